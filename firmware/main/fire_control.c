@@ -0,0 +1,159 @@
+#include "fire_control.h"
+
+#include <string.h>
+
+// Every config read goes through these. tests/bench_press_fixed.c rebuilds this file with them
+// defined as compile-time constants, to measure what reading the config at runtime costs.
+#ifndef FIRE_MIN_HOLD_MS
+#define FIRE_MIN_HOLD_MS(fire) ((fire)->config.min_hold_ms)
+#define FIRE_MAX_HOLD_MS(fire) ((fire)->config.max_hold_ms)
+#define FIRE_LINK_TIMEOUT_MS(fire) ((fire)->config.link_timeout_ms)
+#define FIRE_FRAMES(fire) ((fire)->config.frames)
+#define FIRE_FRAME_COUNT(fire) ((fire)->config.frame_count)
+#endif
+
+static void set_levels(fire_control_t* fire, const uint8_t* level) {
+    memcpy(fire->level, level, sizeof(fire->level));
+    fire->hooks.set_levels(fire->hooks.ctx, fire->level);
+}
+
+static uint32_t held_ms(const fire_control_t* fire) {
+    int64_t diff = fire->hooks.now_us(fire->hooks.ctx) - fire->start_us;
+    return diff > 0 ? (uint32_t)(diff / 1000) : 0;
+}
+
+static uint32_t clamp_hold_ms(const fire_control_t* fire, uint32_t hold_ms) {
+    if (hold_ms < FIRE_MIN_HOLD_MS(fire)) {
+        return FIRE_MIN_HOLD_MS(fire);
+    }
+    if (hold_ms > FIRE_MAX_HOLD_MS(fire)) {
+        return FIRE_MAX_HOLD_MS(fire);
+    }
+    return hold_ms;
+}
+
+static void schedule_next_frame(fire_control_t* fire) {
+    size_t next = fire->frame + 1;
+    if (next >= FIRE_FRAME_COUNT(fire)) {
+        return;
+    }
+    int64_t due_us = fire->start_us + (int64_t)FIRE_FRAMES(fire)[next].at_ms * 1000LL;
+    int64_t delay_us = due_us - fire->hooks.now_us(fire->hooks.ctx);
+    fire->hooks.timer_start(fire->hooks.ctx, FIRE_TIMER_FRAME, delay_us > 0 ? delay_us : 0);
+}
+
+static void apply_frame(fire_control_t* fire, size_t index) {
+    fire->frame = index;
+    set_levels(fire, FIRE_FRAMES(fire)[index].level);
+}
+
+static void stop(fire_control_t* fire, fire_stop_t reason) {
+    static const uint8_t off[SOLENOID_CHANNELS] = {0};
+    uint32_t fired_ms = held_ms(fire);
+    fire->active = false;
+    fire->release_pending = false;
+    for (int timer = 0; timer < FIRE_TIMER_COUNT; timer++) {
+        fire->hooks.timer_stop(fire->hooks.ctx, (fire_timer_t)timer);
+    }
+    set_levels(fire, off);
+    fire->hooks.on_stop(fire->hooks.ctx, reason, fired_ms);
+}
+
+static void cutoff_max_hold(fire_control_t* fire) {
+    fire->last_hold_ms = FIRE_MAX_HOLD_MS(fire);
+    fire->ignore_until_release[fire->source] = true;
+    stop(fire, FIRE_STOP_MAX_HOLD);
+}
+
+void fire_control_init(fire_control_t* fire, const fire_hooks_t* hooks,
+                       const fire_config_t* config) {
+    memset(fire, 0, sizeof(*fire));
+    fire->hooks = *hooks;
+    fire->config = *config;
+    fire->source = PRESS_SOURCE_WS;
+    fire->last_hold_ms = config->min_hold_ms;
+}
+
+void fire_control_set_config(fire_control_t* fire, const fire_config_t* config) {
+    fire->config = *config;
+}
+
+bool fire_control_press_down(fire_control_t* fire, press_source_t source) {
+    if (fire->active || fire->ignore_until_release[source] || FIRE_FRAME_COUNT(fire) == 0) {
+        return false;
+    }
+
+    fire->source = source;
+    fire->active = true;
+    fire->release_pending = false;
+    fire->start_us = fire->hooks.now_us(fire->hooks.ctx);
+    fire->hooks.on_start(fire->hooks.ctx);
+    apply_frame(fire, 0);
+
+    fire->hooks.timer_start(fire->hooks.ctx, FIRE_TIMER_MAX_HOLD,
+                            (int64_t)FIRE_MAX_HOLD_MS(fire) * 1000LL);
+    schedule_next_frame(fire);
+    return true;
+}
+
+void fire_control_press_up(fire_control_t* fire, press_source_t source) {
+    fire->ignore_until_release[source] = false;
+    if (!fire->active || source != fire->source) {
+        return;
+    }
+
+    uint32_t held = held_ms(fire);
+    fire->last_hold_ms = clamp_hold_ms(fire, held);
+    if (held < FIRE_MIN_HOLD_MS(fire)) {
+        fire->release_pending = true;
+        fire->hooks.timer_start(fire->hooks.ctx, FIRE_TIMER_MIN_HOLD,
+                                (int64_t)(FIRE_MIN_HOLD_MS(fire) - held) * 1000LL);
+        return;
+    }
+    stop(fire, FIRE_STOP_RELEASE);
+}
+
+void fire_control_timer_expired(fire_control_t* fire, fire_timer_t timer) {
+    if (!fire->active) {
+        return;
+    }
+    switch (timer) {
+    case FIRE_TIMER_FRAME:
+        if (fire->frame + 1 < FIRE_FRAME_COUNT(fire)) {
+            apply_frame(fire, fire->frame + 1);
+            schedule_next_frame(fire);
+        }
+        break;
+    case FIRE_TIMER_MIN_HOLD:
+        if (fire->release_pending) {
+            stop(fire, FIRE_STOP_RELEASE);
+        }
+        break;
+    case FIRE_TIMER_MAX_HOLD:
+        cutoff_max_hold(fire);
+        break;
+    default:
+        break;
+    }
+}
+
+bool fire_control_poll(fire_control_t* fire, int64_t last_link_rx_us) {
+    if (!fire->active) {
+        return false;
+    }
+    int64_t now = fire->hooks.now_us(fire->hooks.ctx);
+    if (now - fire->start_us >= (int64_t)FIRE_MAX_HOLD_MS(fire) * 1000LL) {
+        cutoff_max_hold(fire);
+        return true;
+    }
+    if (fire->source == PRESS_SOURCE_WS && last_link_rx_us != 0 &&
+        now - last_link_rx_us > (int64_t)FIRE_LINK_TIMEOUT_MS(fire) * 1000LL) {
+        stop(fire, FIRE_STOP_LINK);
+        return true;
+    }
+    return false;
+}
+
+uint32_t fire_control_elapsed_ms(const fire_control_t* fire) {
+    return fire->active ? held_ms(fire) : 0;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Press/release, min/max hold, link timeout and solenoid frame stepping for one fire.
+//
+// No ESP-IDF dependencies: the clock, the solenoid outputs and the one-shot timers are reached
+// through hooks, so the same code runs on the device and in the host replay runner. Callers
+// serialise access (state_lock on the device).
+
+// Pixel 1 drives solenoids 1 and 2, pixel 2 drives solenoid 3 (see README).
+#define SOLENOID_CHANNELS 2
+
+// Pixel levels for all channels from at_ms (relative to fire start) until the next frame.
+typedef struct {
+    uint32_t at_ms;
+    uint8_t level[SOLENOID_CHANNELS];
+} solenoid_frame_t;
+
+typedef enum {
+    PRESS_SOURCE_WS = 0,
+    PRESS_SOURCE_TRIGGER,
+    PRESS_SOURCE_COUNT,
+} press_source_t;
+
+typedef enum {
+    FIRE_TIMER_FRAME = 0,
+    FIRE_TIMER_MIN_HOLD,
+    FIRE_TIMER_MAX_HOLD,
+    FIRE_TIMER_COUNT,
+} fire_timer_t;
+
+typedef enum {
+    FIRE_STOP_RELEASE = 0, // released after min hold, or the deferred min-hold stop
+    FIRE_STOP_MAX_HOLD,
+    FIRE_STOP_LINK,
+} fire_stop_t;
+
+typedef struct {
+    uint32_t min_hold_ms;
+    uint32_t max_hold_ms;
+    uint32_t link_timeout_ms;
+    const solenoid_frame_t* frames;
+    size_t frame_count;
+} fire_config_t;
+
+typedef struct {
+    int64_t (*now_us)(void* ctx);
+    // Called with the new level of every channel whenever the outputs change.
+    void (*set_levels)(void* ctx, const uint8_t* level);
+    // One-shot timers; starting a running timer restarts it. The owner calls
+    // fire_control_timer_expired() when one fires.
+    void (*timer_start)(void* ctx, fire_timer_t timer, int64_t delay_us);
+    void (*timer_stop)(void* ctx, fire_timer_t timer);
+    // Start is reported before the first frame is applied, stop after the outputs are off.
+    void (*on_start)(void* ctx);
+    void (*on_stop)(void* ctx, fire_stop_t reason, uint32_t fired_ms);
+    void* ctx;
+} fire_hooks_t;
+
+typedef struct {
+    fire_hooks_t hooks;
+    fire_config_t config;
+    bool active;
+    // Set for the source a max-hold cutoff stopped, until that source releases. Per source, so
+    // a WS client that drops mid-cutoff does not lock out the trigger, or the other way round.
+    bool ignore_until_release[PRESS_SOURCE_COUNT];
+    bool release_pending;
+    press_source_t source;
+    int64_t start_us;
+    uint32_t last_hold_ms;
+    size_t frame;
+    uint8_t level[SOLENOID_CHANNELS];
+} fire_control_t;
+
+void fire_control_init(fire_control_t* fire, const fire_hooks_t* hooks,
+                       const fire_config_t* config);
+
+// Only takes effect for the next press; the caller defers swaps until no press is active.
+void fire_control_set_config(fire_control_t* fire, const fire_config_t* config);
+
+// Returns true if the press started a fire.
+bool fire_control_press_down(fire_control_t* fire, press_source_t source);
+
+// A release only ends a press from the same source, so a stray WS UP cannot cut a trigger burn
+// short and vice versa. It always re-arms its own source after a max-hold cutoff.
+void fire_control_press_up(fire_control_t* fire, press_source_t source);
+
+void fire_control_timer_expired(fire_control_t* fire, fire_timer_t timer);
+
+// Periodic backstop: the max-hold cutoff if its timer was missed, and the link timeout for WS
+// presses. last_link_rx_us is the last inbound WS frame (0 if none). Returns true if it stopped
+// a fire.
+bool fire_control_poll(fire_control_t* fire, int64_t last_link_rx_us);
+
+uint32_t fire_control_elapsed_ms(const fire_control_t* fire);
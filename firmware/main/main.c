@@ -1,5 +1,6 @@
 #include <ctype.h>
 #include <inttypes.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -11,6 +12,7 @@
 #include "freertos/semphr.h"
 #include "freertos/task.h"
 
+#include "esp_attr.h"
 #include "esp_event.h"
 #include "esp_log.h"
 #include "esp_netif.h"
@@ -27,15 +29,60 @@
 #include "driver/gpio.h"
 #include "led_strip.h"
 
-#define AP_SSID "Poofer-AP"
-#define AP_PASS "FlameoHotMan"
+#include "fire_control.h"
+#include "trigger_debounce.h"
+
+#define DEFAULT_AP_SSID "Poofer-AP"
+#define DEFAULT_AP_PASS "FlameoHotMan"
 #define AP_MAX_CONN 4
 
 #define WS_URI "/ws"
-#define MAX_HOLD_MS 3000
-#define MIN_HOLD_MS 250
-#define SOLENOID_KICK_MS 50
-#define SOLENOID_HOLD_LEVEL 255
+#define WS_MAX_CLIENTS AP_MAX_CONN
+#define WS_MAX_INFLIGHT 2
+#define DEFAULT_STREAM_HZ 50
+#define STREAM_LIMIT_MIN_HZ 5
+#define STREAM_LIMIT_MAX_HZ 100
+#define DEFAULT_MAX_HOLD_MS 3000
+#define DEFAULT_MIN_HOLD_MS 250
+#define DEFAULT_LINK_TIMEOUT_MS 2000
+
+// Hard limits enforced on any runtime config, regardless of what is stored in NVS.
+#define HOLD_LIMIT_MIN_MS 50
+#define HOLD_LIMIT_MAX_MS 10000
+#define LINK_TIMEOUT_LIMIT_MIN_MS 500
+#define LINK_TIMEOUT_LIMIT_MAX_MS 10000
+#define KICK_LIMIT_MAX_MS 1000
+#define COIL_LIMIT_MAX_MA 5000
+
+// Background AP scan for the setup page. Scheduled scans only run while no controller is
+// connected; on-demand scans are rate limited. Neither starts while firing.
+#define WIFI_SCAN_TABLE_SIZE 16
+#define WIFI_SCAN_MAX_RECORDS 32
+#define WIFI_SCAN_PERIOD_MS 60000
+#define WIFI_SCAN_MIN_INTERVAL_MS 10000
+#define WIFI_SCAN_CHANNEL_MS 80
+#define WIFI_SCAN_HOME_DWELL_MS 60
+
+// The status task sends each controller a {"probe":N} frame this often and times the "ACK N"
+// reply. A probe still unanswered when the next one is due counts as lost.
+#define LINK_PROBE_PERIOD_MS 1000
+
+#define CAPTURE_RECORDS 1024
+#define CAPTURE_MAGIC "PFCP"
+#define CAPTURE_VERSION 3
+
+#define CRASH_RECORD_MAGIC 0x50464352 // "PFCR"
+// POST /fault waits at least this long before crashing, so its reply gets out first.
+#define FAULT_MIN_DELAY_MS 100
+
+#define CONFIG_NVS_NAMESPACE "poofer"
+#define CONFIG_NVS_KEY "config"
+#define CONFIG_VERSION 3
+
+#define SOLENOID_MAX_DECAY_STEPS 6
+#define SOLENOID_MAX_FRAMES (SOLENOID_CHANNELS * (SOLENOID_MAX_DECAY_STEPS + 1) + 1)
+#define SOLENOID_SUPPLY_MV 12000
+#define SOLENOID_COIL_MA 500
 
 #define STATUS_LED_INDEX 0
 #define SOLENOID_PIXEL_INDEX 1
@@ -43,6 +90,16 @@
 
 #define GPIO_NEOPIXEL GPIO_NUM_4
 
+// Local dead-man trigger: active low with the internal pull-up, so an unplugged switch reads
+// as released. Disabled (-1) unless a pin is configured.
+#define DEFAULT_TRIGGER_GPIO -1
+#define DEFAULT_TRIGGER_DEBOUNCE_MS 10
+#define TRIGGER_DEBOUNCE_LIMIT_MAX_MS 100
+// Super Mini pins free for the switch: not the pixel chain (4), the strapping pins (2, 8, 9; 8 is
+// also the on-board LED) or UART0 (20, 21), which carries the console.
+#define TRIGGER_GPIO_ALLOWED                                                                       \
+    ((1UL << 0) | (1UL << 1) | (1UL << 3) | (1UL << 5) | (1UL << 6) | (1UL << 7) | (1UL << 10))
+
 #define TAG "poofer"
 
 typedef enum {
@@ -51,18 +108,198 @@ typedef enum {
     STATE_FIRING,
     STATE_DISCONNECTED,
     STATE_ERROR,
+    STATE_COUNT,
 } system_state_t;
 
+// Kick-and-hold drive for one solenoid channel. The coil gets kick_level for kick_ms to
+// guarantee pull-in, then steps down to hold_level over decay_steps steps of decay_step_ms.
+typedef struct {
+    uint8_t kick_level;
+    uint16_t kick_ms;
+    uint8_t hold_level;
+    uint8_t decay_steps;
+    uint16_t decay_step_ms;
+    uint16_t coil_ma; // coil current at full drive, used for energy estimates
+} solenoid_profile_t;
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} status_color_t;
+
+// Persisted as one NVS blob. Fields are only ever appended; bump CONFIG_VERSION when doing so
+// and reset the new fields to their defaults for older versions in config_load.
+typedef struct {
+    uint16_t version;
+    uint16_t size;
+    uint32_t min_hold_ms;
+    uint32_t max_hold_ms;
+    uint32_t link_timeout_ms;
+    char ap_ssid[33];
+    char ap_pass[65];
+    status_color_t status_colors[STATE_COUNT];
+    solenoid_profile_t solenoid_profiles[SOLENOID_CHANNELS];
+    // v2
+    uint16_t stream_hz;
+    // v3
+    int8_t trigger_gpio;
+    uint16_t trigger_debounce_ms;
+} poofer_config_t;
+
+// A validated config plus everything derived from it. The hot path only ever reads the slot
+// `config` points at; updates are built in the other slot and swapped in between presses.
+typedef struct {
+    poofer_config_t values;
+    solenoid_frame_t solenoid_frames[SOLENOID_MAX_FRAMES];
+    size_t solenoid_frame_count;
+} config_slot_t;
+
+typedef struct {
+    int fd;
+    uint8_t inflight;
+    bool stale; // skipped for backlog; gets the newest frame on its next free tick
+} ws_client_t;
+
+typedef enum {
+    WS_SEND_STATE,       // a state frame to every client
+    WS_SEND_STATE_STALE, // a state frame to the clients that missed the last one
+    WS_SEND_PROBE,       // a link probe; never touches the stale bookkeeping
+} ws_send_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} latency_stats_t;
+
+typedef enum {
+    CAPTURE_WS_OPEN = 1,
+    CAPTURE_RX_DOWN,
+    CAPTURE_RX_UP,
+    CAPTURE_RX_PING,
+    CAPTURE_RX_OTHER,
+    CAPTURE_TX_STATE,
+    CAPTURE_SOLENOID,
+    CAPTURE_TRIGGER_DOWN,
+    CAPTURE_TRIGGER_UP,
+    CAPTURE_SCAN_START,
+    CAPTURE_SCAN_DONE,
+} capture_kind_t;
+
+#define CAPTURE_FLAG_READY (1U << 0)
+#define CAPTURE_FLAG_FIRING (1U << 1)
+#define CAPTURE_FLAG_ERROR (1U << 2)
+#define CAPTURE_FLAG_CONNECTED (1U << 3)
+
+// One captured event. TX_STATE carries the state flags, elapsed_ms (a) and last_hold_ms (b);
+// SOLENOID carries the new channel levels; RX records carry the frame length in a; SCAN_DONE
+// carries the cached AP count (a) and the scan duration in ms (b).
+typedef struct {
+    uint32_t t_us; // since capture start, wraps after ~71 minutes
+    uint8_t kind;
+    uint8_t flags;
+    uint8_t level[SOLENOID_CHANNELS];
+    uint32_t a;
+    uint32_t b;
+} capture_record_t;
+
+_Static_assert(sizeof(capture_record_t) == 16, "capture record layout is part of the file format");
+
+// Download layout: this header, frame_count solenoid frames, then count records oldest first.
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t count;
+    uint32_t dropped;
+    uint32_t min_hold_ms;
+    uint32_t max_hold_ms;
+    uint32_t link_timeout_ms;
+    uint32_t frame_count;
+} capture_header_t;
+
+typedef struct {
+    uint32_t at_ms;
+    uint8_t level[SOLENOID_CHANNELS];
+    uint8_t reserved[2];
+} capture_frame_t;
+
+typedef struct {
+    volatile bool enabled;
+    int64_t start_us;
+    size_t head;
+    size_t count;
+    capture_header_t header;
+    capture_frame_t frames[SOLENOID_MAX_FRAMES];
+    capture_record_t* records; // CAPTURE_RECORDS entries, only allocated while enabled
+} capture_state_t;
+
+typedef struct {
+    char ssid[33];
+    int8_t rssi;
+    uint8_t channel;
+    bool secure;
+} wifi_scan_entry_t;
+
+typedef struct {
+    bool requested;
+    bool active;
+    bool aborted; // stopped for a press; the SCAN_DONE event still has to arrive
+    int64_t started_us;
+    int64_t done_us;
+    uint32_t duration_ms;
+    uint32_t scans;
+    uint32_t failures;
+    size_t count;
+    wifi_scan_entry_t entries[WIFI_SCAN_TABLE_SIZE];
+} wifi_scan_state_t;
+
+// Kept in RTC memory, which survives panics and watchdog resets but not a power cycle. Updated
+// on every fire edge and on the status task heartbeat.
+typedef struct {
+    uint32_t magic;
+    uint32_t boot_count;
+    uint32_t uptime_ms;
+    uint32_t press_start_ms;
+    uint8_t state;
+    uint8_t press_active;
+    uint8_t press_source;
+    uint8_t reserved;
+    uint32_t checksum;
+} crash_record_t;
+
+// What the previous run left behind, plus how long this boot took to get safe and controllable.
+typedef struct {
+    esp_reset_reason_t reset_reason;
+    const char* fault; // NULL unless the last reset was a crash
+    bool record_valid;
+    system_state_t last_state;
+    bool was_firing;
+    uint32_t fire_ms; // burn length at the last update before the reset
+    uint32_t boot_count;
+    int64_t safe_us;
+    int64_t control_ready_us;
+} boot_report_t;
+
 typedef struct {
     system_state_t state;
-    bool press_active;
-    bool press_ignore_until_release;
-    bool release_pending;
-    int64_t press_start_us;
-    uint32_t last_hold_ms;
+    fire_control_t fire;
     int64_t last_ws_rx_us;
     bool ws_connected;
-    uint8_t solenoid_level;
+    bool push_pending;
+    uint32_t last_fire_mj;
+    uint32_t press_cost_us;
+    uint32_t press_cost_max_us;
+    uint32_t trigger_latency_us;
+    uint32_t trigger_latency_max_us;
+    uint32_t link_probe_seq;
+    int64_t link_probe_sent_us;
+    bool link_probe_pending;
+    uint32_t link_probes_lost;
+    latency_stats_t link_rtt_idle; // probe round trips with no scan running
+    latency_stats_t link_rtt_scan; // probe round trips that overlapped a scan
     uint8_t status_r;
     uint8_t status_g;
     uint8_t status_b;
@@ -70,17 +307,33 @@ typedef struct {
 
 static led_strip_handle_t strip = NULL;
 static httpd_handle_t httpd = NULL;
-static int ws_client_fd = -1;
+static ws_client_t ws_clients[WS_MAX_CLIENTS];
+static portMUX_TYPE ws_clients_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t ws_frames_skipped;
+static capture_state_t capture;
+static TaskHandle_t trigger_task_handle;
+static TaskHandle_t status_task_handle;
+static int64_t trigger_edge_us;
+static portMUX_TYPE trigger_mux = portMUX_INITIALIZER_UNLOCKED;
+static portMUX_TYPE capture_mux = portMUX_INITIALIZER_UNLOCKED;
+static wifi_scan_state_t wifi_scan;
+static portMUX_TYPE wifi_scan_mux = portMUX_INITIALIZER_UNLOCKED;
+static RTC_NOINIT_ATTR crash_record_t crash_record;
+static boot_report_t boot_report;
 static runtime_state_t runtime = {
     .state = STATE_BOOT,
-    .press_active = false,
-    .press_ignore_until_release = false,
-    .release_pending = false,
-    .press_start_us = 0,
-    .last_hold_ms = MIN_HOLD_MS,
     .last_ws_rx_us = 0,
     .ws_connected = false,
-    .solenoid_level = 0,
+    .push_pending = false,
+    .last_fire_mj = 0,
+    .press_cost_us = 0,
+    .press_cost_max_us = 0,
+    .trigger_latency_us = 0,
+    .trigger_latency_max_us = 0,
+    .link_probe_seq = 0,
+    .link_probe_sent_us = 0,
+    .link_probe_pending = false,
+    .link_probes_lost = 0,
     .status_r = 0,
     .status_g = 0,
     .status_b = 0,
@@ -90,504 +343,1831 @@ static esp_timer_handle_t max_hold_timer;
 static esp_timer_handle_t min_hold_timer;
 static esp_timer_handle_t solenoid_kick_timer;
 
-static void refresh_pixels_locked(void) {
-    if (!strip) {
+static config_slot_t config_slots[2];
+static const config_slot_t* config = &config_slots[0];
+static const config_slot_t* config_pending = NULL;
+
+static const poofer_config_t config_defaults = {
+    .version = CONFIG_VERSION,
+    .size = sizeof(poofer_config_t),
+    .min_hold_ms = DEFAULT_MIN_HOLD_MS,
+    .max_hold_ms = DEFAULT_MAX_HOLD_MS,
+    .link_timeout_ms = DEFAULT_LINK_TIMEOUT_MS,
+    .ap_ssid = DEFAULT_AP_SSID,
+    .ap_pass = DEFAULT_AP_PASS,
+    .status_colors =
+        {
+            [STATE_BOOT] = {122, 138, 160},     // idle/muted (#7a8aa0)
+            [STATE_READY] = {29, 185, 84},      // ready green (#1db954)
+            [STATE_FIRING] = {255, 138, 0},     // firing orange (#ff8a00)
+            [STATE_DISCONNECTED] = {0, 0, 255}, // disconnected blue (#0000ff)
+            [STATE_ERROR] = {230, 57, 70},      // error red (#e63946)
+        },
+    .solenoid_profiles =
+        {
+            {
+                .kick_level = 255,
+                .kick_ms = 50,
+                .hold_level = 160,
+                .decay_steps = 2,
+                .decay_step_ms = 10,
+                .coil_ma = 2 * SOLENOID_COIL_MA,
+            },
+            {
+                .kick_level = 255,
+                .kick_ms = 50,
+                .hold_level = 160,
+                .decay_steps = 2,
+                .decay_step_ms = 10,
+                .coil_ma = SOLENOID_COIL_MA,
+            },
+        },
+    .stream_hz = DEFAULT_STREAM_HZ,
+    .trigger_gpio = DEFAULT_TRIGGER_GPIO,
+    .trigger_debounce_ms = DEFAULT_TRIGGER_DEBOUNCE_MS,
+};
+
+static void capture_record(capture_kind_t kind, uint8_t flags, const uint8_t* level, uint32_t a,
+                           uint32_t b) {
+    if (!capture.enabled) {
         return;
     }
-    led_strip_set_pixel(strip, STATUS_LED_INDEX, runtime.status_r, runtime.status_g,
-                        runtime.status_b);
-    led_strip_set_pixel(strip, SOLENOID_PIXEL_INDEX, runtime.solenoid_level, runtime.solenoid_level,
-                        runtime.solenoid_level);
-    led_strip_set_pixel(strip, FIRING_PIXEL_INDEX, runtime.solenoid_level, runtime.solenoid_level,
-                        runtime.solenoid_level);
-    led_strip_refresh(strip);
-}
-
-static void set_solenoid_level_locked(uint8_t level) {
-    runtime.solenoid_level = level;
-    refresh_pixels_locked();
-}
-
-static void update_status_led_locked(void) {
-    switch (runtime.state) {
-    case STATE_BOOT:
-        runtime.status_r = 122;
-        runtime.status_g = 138;
-        runtime.status_b = 160; // idle/muted (#7a8aa0)
-        break;
-    case STATE_READY:
-        runtime.status_r = 29;
-        runtime.status_g = 185;
-        runtime.status_b = 84; // ready green (#1db954)
-        break;
-    case STATE_FIRING:
-        runtime.status_r = 255;
-        runtime.status_g = 138;
-        runtime.status_b = 0; // firing orange (#ff8a00)
-        break;
-    case STATE_DISCONNECTED:
-        runtime.status_r = 0;
-        runtime.status_g = 0;
-        runtime.status_b = 255; // disconnected blue (#0000ff)
-        break;
-    case STATE_ERROR:
-    default:
-        runtime.status_r = 230;
-        runtime.status_g = 57;
-        runtime.status_b = 70; // error red (#e63946)
-        break;
+    taskENTER_CRITICAL(&capture_mux);
+    if (capture.enabled && capture.records) {
+        // Timestamp inside the critical section so records are in time order.
+        capture_record_t* rec = &capture.records[capture.head];
+        rec->t_us = (uint32_t)(esp_timer_get_time() - capture.start_us);
+        rec->kind = (uint8_t)kind;
+        rec->flags = flags;
+        if (level) {
+            memcpy(rec->level, level, sizeof(rec->level));
+        } else {
+            memset(rec->level, 0, sizeof(rec->level));
+        }
+        rec->a = a;
+        rec->b = b;
+        capture.head = (capture.head + 1) % CAPTURE_RECORDS;
+        if (capture.count < CAPTURE_RECORDS) {
+            capture.count++;
+        } else {
+            capture.header.dropped++;
+        }
     }
-    refresh_pixels_locked();
+    taskEXIT_CRITICAL(&capture_mux);
 }
 
-static uint32_t clamp_hold_ms(uint32_t hold_ms) {
-    if (hold_ms < MIN_HOLD_MS) {
-        return MIN_HOLD_MS;
-    }
-    if (hold_ms > MAX_HOLD_MS) {
-        return MAX_HOLD_MS;
+static void capture_ws_rx(const char* msg, size_t len) {
+    capture_kind_t kind = CAPTURE_RX_OTHER;
+    if (strcmp(msg, "DOWN") == 0) {
+        kind = CAPTURE_RX_DOWN;
+    } else if (strcmp(msg, "UP") == 0) {
+        kind = CAPTURE_RX_UP;
+    } else if (strcmp(msg, "PING") == 0) {
+        kind = CAPTURE_RX_PING;
     }
-    return hold_ms;
+    capture_record(kind, 0, NULL, (uint32_t)len, 0);
 }
 
-static uint32_t current_elapsed_ms_locked(void) {
-    if (!runtime.press_active) {
-        return 0;
+// Starting a capture allocates and clears the ring and snapshots the timing config the replay
+// tool needs. Stopping frees the ring, so a capture must be downloaded before it is stopped.
+static esp_err_t capture_set_enabled_locked(bool enabled) {
+    taskENTER_CRITICAL(&capture_mux);
+    capture.enabled = false;
+    capture_record_t* records = capture.records;
+    capture.records = NULL;
+    taskEXIT_CRITICAL(&capture_mux);
+    if (!enabled) {
+        free(records);
+        memset(&capture.header, 0, sizeof(capture.header));
+        return ESP_OK;
     }
-    int64_t now = esp_timer_get_time();
-    int64_t diff = now - runtime.press_start_us;
-    if (diff < 0) {
-        return 0;
+    if (!records) {
+        records = malloc(CAPTURE_RECORDS * sizeof(capture_record_t));
+        if (!records) {
+            return ESP_ERR_NO_MEM;
+        }
     }
-    return (uint32_t)(diff / 1000);
-}
 
-static void send_state_async(void) {
-    if (!httpd || ws_client_fd < 0) {
-        return;
+    memset(&capture.header, 0, sizeof(capture.header));
+    memcpy(capture.header.magic, CAPTURE_MAGIC, sizeof(capture.header.magic));
+    capture.header.version = CAPTURE_VERSION;
+    capture.header.record_size = sizeof(capture_record_t);
+    capture.header.min_hold_ms = config->values.min_hold_ms;
+    capture.header.max_hold_ms = config->values.max_hold_ms;
+    capture.header.link_timeout_ms = config->values.link_timeout_ms;
+    capture.header.frame_count = (uint32_t)config->solenoid_frame_count;
+    memset(capture.frames, 0, sizeof(capture.frames));
+    for (size_t i = 0; i < config->solenoid_frame_count; i++) {
+        capture.frames[i].at_ms = config->solenoid_frames[i].at_ms;
+        memcpy(capture.frames[i].level, config->solenoid_frames[i].level,
+               sizeof(capture.frames[i].level));
     }
 
-    char payload[192];
-    bool ready = false;
-    bool firing = false;
-    bool error = false;
-    bool connected = false;
-    uint32_t elapsed = 0;
-    uint32_t last_hold = 0;
+    taskENTER_CRITICAL(&capture_mux);
+    capture.records = records;
+    capture.head = 0;
+    capture.count = 0;
+    capture.start_us = esp_timer_get_time();
+    capture.enabled = true;
+    taskEXIT_CRITICAL(&capture_mux);
+    return ESP_OK;
+}
 
-    if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) == pdTRUE) {
-        ready = (runtime.state == STATE_READY || runtime.state == STATE_FIRING);
-        firing = (runtime.state == STATE_FIRING);
-        error = (runtime.state == STATE_ERROR);
-        connected = runtime.ws_connected;
-        elapsed = current_elapsed_ms_locked();
-        last_hold = runtime.last_hold_ms;
-        xSemaphoreGive(state_lock);
+static uint32_t crash_record_checksum(const crash_record_t* record) {
+    const uint8_t* bytes = (const uint8_t*)record;
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < offsetof(crash_record_t, checksum); i++) {
+        hash = (hash ^ bytes[i]) * 16777619U;
     }
+    return hash;
+}
 
-    int len = snprintf(payload, sizeof(payload),
-                       "{\"ready\":%s,\"firing\":%s,\"error\":%s,\"connected\":%s,"
-                       "\"elapsed_ms\":%" PRIu32 ",\"last_hold_ms\":%" PRIu32 "}",
-                       ready ? "true" : "false", firing ? "true" : "false",
-                       error ? "true" : "false", connected ? "true" : "false", elapsed, last_hold);
-    if (len <= 0 || len >= (int)sizeof(payload)) {
-        return;
-    }
+// Plain stores into RTC RAM; cheap enough for the fire path.
+static void crash_record_update_locked(void) {
+    crash_record.magic = CRASH_RECORD_MAGIC;
+    crash_record.uptime_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    crash_record.press_start_ms = (uint32_t)(runtime.fire.start_us / 1000);
+    crash_record.state = (uint8_t)runtime.state;
+    crash_record.press_active = runtime.fire.active;
+    crash_record.press_source = (uint8_t)runtime.fire.source;
+    crash_record.reserved = 0;
+    crash_record.checksum = crash_record_checksum(&crash_record);
+}
 
-    httpd_ws_frame_t frame = {
-        .final = true,
-        .fragmented = false,
-        .type = HTTPD_WS_TYPE_TEXT,
-        .payload = (uint8_t*)payload,
-        .len = (size_t)len,
-    };
-    httpd_ws_send_frame_async(httpd, ws_client_fd, &frame);
+static const char* reset_reason_name(esp_reset_reason_t reason) {
+    switch (reason) {
+    case ESP_RST_POWERON:
+        return "poweron";
+    case ESP_RST_EXT:
+        return "ext";
+    case ESP_RST_SW:
+        return "sw";
+    case ESP_RST_PANIC:
+        return "panic";
+    case ESP_RST_INT_WDT:
+        return "int_wdt";
+    case ESP_RST_TASK_WDT:
+        return "task_wdt";
+    case ESP_RST_WDT:
+        return "wdt";
+    case ESP_RST_DEEPSLEEP:
+        return "deepsleep";
+    case ESP_RST_BROWNOUT:
+        return "brownout";
+    default:
+        return "unknown";
+    }
 }
 
-static void stop_firing_locked(system_state_t next_state) {
-    runtime.press_active = false;
-    runtime.release_pending = false;
-    runtime.state = next_state;
-    set_solenoid_level_locked(0);
-    update_status_led_locked();
+static bool reset_reason_is_fault(esp_reset_reason_t reason) {
+    return reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT || reason == ESP_RST_TASK_WDT ||
+           reason == ESP_RST_WDT || reason == ESP_RST_BROWNOUT;
 }
 
-static void start_firing_locked(void) {
-    runtime.state = STATE_FIRING;
-    runtime.press_active = true;
-    runtime.release_pending = false;
-    runtime.press_start_us = esp_timer_get_time();
-    update_status_led_locked();
-    set_solenoid_level_locked(255);
+// Reads what the previous run left in RTC memory, then starts a fresh record for this boot.
+static void boot_report_init(void) {
+    boot_report.reset_reason = esp_reset_reason();
+    boot_report.record_valid = crash_record.magic == CRASH_RECORD_MAGIC &&
+                               crash_record.checksum == crash_record_checksum(&crash_record);
+    if (reset_reason_is_fault(boot_report.reset_reason)) {
+        boot_report.fault = reset_reason_name(boot_report.reset_reason);
+    }
+    if (boot_report.record_valid) {
+        boot_report.last_state =
+            crash_record.state < STATE_COUNT ? (system_state_t)crash_record.state : STATE_ERROR;
+        boot_report.was_firing = crash_record.press_active;
+        if (boot_report.was_firing && crash_record.uptime_ms >= crash_record.press_start_ms) {
+            boot_report.fire_ms = crash_record.uptime_ms - crash_record.press_start_ms;
+        }
+        boot_report.boot_count = crash_record.boot_count + 1;
+    } else {
+        boot_report.boot_count = 1;
+        memset(&crash_record, 0, sizeof(crash_record));
+    }
+
+    crash_record.boot_count = boot_report.boot_count;
+    crash_record_update_locked();
+
+    if (boot_report.fault) {
+        ESP_LOGW(TAG, "Recovered from %s, boot %" PRIu32 ", was firing: %s (%" PRIu32 " ms)",
+                 boot_report.fault, boot_report.boot_count, boot_report.was_firing ? "yes" : "no",
+                 boot_report.fire_ms);
+    }
+    ESP_LOGI(TAG, "Outputs safe %lld us after start", (long long)boot_report.safe_us);
 }
 
-static void max_hold_timer_cb(void* arg) {
-    (void)arg;
-    if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) != pdTRUE) {
+static void refresh_pixels_locked(void) {
+    if (!strip) {
         return;
     }
+    led_strip_set_pixel(strip, STATUS_LED_INDEX, runtime.status_r, runtime.status_g,
+                        runtime.status_b);
+    uint8_t sol = runtime.fire.level[0];
+    uint8_t fire = runtime.fire.level[1];
+    led_strip_set_pixel(strip, SOLENOID_PIXEL_INDEX, sol, sol, sol);
+    led_strip_set_pixel(strip, FIRING_PIXEL_INDEX, fire, fire, fire);
+    led_strip_refresh(strip);
+}
 
-    if (runtime.press_active) {
-        runtime.last_hold_ms = MAX_HOLD_MS;
-        runtime.press_active = false;
-        runtime.press_ignore_until_release = true;
-        runtime.state = STATE_READY;
-        set_solenoid_level_locked(0);
-        update_status_led_locked();
+static uint8_t solenoid_profile_level_at(const solenoid_profile_t* profile, uint32_t at_ms) {
+    if (at_ms < profile->kick_ms) {
+        return profile->kick_level;
     }
-
-    xSemaphoreGive(state_lock);
-    send_state_async();
+    if (profile->decay_steps == 0 || profile->decay_step_ms == 0) {
+        return profile->hold_level;
+    }
+    uint32_t step = 1 + (at_ms - profile->kick_ms) / profile->decay_step_ms;
+    if (step > profile->decay_steps) {
+        return profile->hold_level;
+    }
+    int32_t span = (int32_t)profile->hold_level - (int32_t)profile->kick_level;
+    return (uint8_t)((int32_t)profile->kick_level +
+                     span * (int32_t)step / (int32_t)(profile->decay_steps + 1));
 }
 
-static void min_hold_timer_cb(void* arg) {
-    (void)arg;
-    if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) != pdTRUE) {
+static void solenoid_frame_time_insert(uint32_t* times, size_t* count, uint32_t at_ms) {
+    size_t pos = 0;
+    while (pos < *count && times[pos] < at_ms) {
+        pos++;
+    }
+    if (pos < *count && times[pos] == at_ms) {
         return;
     }
+    memmove(&times[pos + 1], &times[pos], (*count - pos) * sizeof(times[0]));
+    times[pos] = at_ms;
+    (*count)++;
+}
 
-    if (runtime.press_active && runtime.release_pending) {
-        stop_firing_locked(STATE_READY);
+// Flattens the per-channel profiles into one timeline of pixel frames so the kick timer only
+// has to copy precomputed levels out to the strip.
+static size_t build_solenoid_frames(const solenoid_profile_t* profiles, solenoid_frame_t* frames) {
+    uint32_t times[SOLENOID_MAX_FRAMES];
+    size_t count = 0;
+    solenoid_frame_time_insert(times, &count, 0);
+    for (size_t ch = 0; ch < SOLENOID_CHANNELS; ch++) {
+        const solenoid_profile_t* profile = &profiles[ch];
+        uint8_t steps = profile->decay_steps;
+        if (steps > SOLENOID_MAX_DECAY_STEPS) {
+            steps = SOLENOID_MAX_DECAY_STEPS;
+        }
+        for (uint32_t step = 0; step <= steps; step++) {
+            solenoid_frame_time_insert(times, &count,
+                                       profile->kick_ms + step * profile->decay_step_ms);
+        }
     }
 
-    xSemaphoreGive(state_lock);
-    send_state_async();
+    size_t frame_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        solenoid_frame_t frame = {.at_ms = times[i]};
+        for (size_t ch = 0; ch < SOLENOID_CHANNELS; ch++) {
+            frame.level[ch] = solenoid_profile_level_at(&profiles[ch], times[i]);
+        }
+        if (frame_count > 0 &&
+            memcmp(frame.level, frames[frame_count - 1].level, sizeof(frame.level)) == 0) {
+            continue;
+        }
+        frames[frame_count++] = frame;
+    }
+    return frame_count;
 }
 
-static void solenoid_kick_timer_cb(void* arg) {
-    (void)arg;
-    if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) != pdTRUE) {
-        return;
+// Coil energy for a fire of fired_ms, assuming the driver's output duty tracks the pixel level.
+static uint32_t solenoid_energy_mj(const solenoid_frame_t* frames, size_t frame_count,
+                                   const solenoid_profile_t* profiles, uint32_t fired_ms) {
+    uint64_t level_ma_ms = 0;
+    for (size_t i = 0; i < frame_count && frames[i].at_ms < fired_ms; i++) {
+        uint32_t end_ms = fired_ms;
+        if (i + 1 < frame_count && frames[i + 1].at_ms < fired_ms) {
+            end_ms = frames[i + 1].at_ms;
+        }
+        uint32_t span_ms = end_ms - frames[i].at_ms;
+        for (size_t ch = 0; ch < SOLENOID_CHANNELS; ch++) {
+            level_ma_ms += (uint64_t)frames[i].level[ch] * profiles[ch].coil_ma * span_ms;
+        }
     }
+    return (uint32_t)(level_ma_ms * SOLENOID_SUPPLY_MV / 255ULL / 1000000ULL);
+}
+
+static bool config_string_valid(const char* value, size_t size, size_t min_len) {
+    size_t len = strnlen(value, size);
+    return len < size && len >= min_len;
+}
 
-    if (runtime.state == STATE_FIRING) {
-        set_solenoid_level_locked(SOLENOID_HOLD_LEVEL);
+static esp_err_t config_validate(const poofer_config_t* values) {
+    if (values->min_hold_ms < HOLD_LIMIT_MIN_MS || values->max_hold_ms > HOLD_LIMIT_MAX_MS ||
+        values->min_hold_ms >= values->max_hold_ms) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (values->stream_hz < STREAM_LIMIT_MIN_HZ || values->stream_hz > STREAM_LIMIT_MAX_HZ) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int pin = values->trigger_gpio;
+    if (pin != -1 && (pin < 0 || pin >= 32 || !(TRIGGER_GPIO_ALLOWED & (1UL << pin)))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (values->trigger_debounce_ms == 0 ||
+        values->trigger_debounce_ms > TRIGGER_DEBOUNCE_LIMIT_MAX_MS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (values->link_timeout_ms < LINK_TIMEOUT_LIMIT_MIN_MS ||
+        values->link_timeout_ms > LINK_TIMEOUT_LIMIT_MAX_MS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!config_string_valid(values->ap_ssid, sizeof(values->ap_ssid), 1)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!config_string_valid(values->ap_pass, sizeof(values->ap_pass), 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t pass_len = strlen(values->ap_pass);
+    if (pass_len != 0 && pass_len < 8) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t ch = 0; ch < SOLENOID_CHANNELS; ch++) {
+        const solenoid_profile_t* profile = &values->solenoid_profiles[ch];
+        // A zero hold level would drop the valve right after the kick while still firing.
+        if (profile->kick_level == 0 || profile->hold_level == 0 ||
+            profile->kick_ms > KICK_LIMIT_MAX_MS ||
+            profile->decay_steps > SOLENOID_MAX_DECAY_STEPS ||
+            profile->coil_ma > COIL_LIMIT_MAX_MA) {
+            return ESP_ERR_INVALID_ARG;
+        }
     }
+    return ESP_OK;
+}
 
-    xSemaphoreGive(state_lock);
+static void config_slot_build(config_slot_t* slot, const poofer_config_t* values) {
+    slot->values = *values;
+    slot->values.version = CONFIG_VERSION;
+    slot->values.size = sizeof(poofer_config_t);
+    slot->solenoid_frame_count =
+        build_solenoid_frames(slot->values.solenoid_profiles, slot->solenoid_frames);
 }
 
-static void handle_press_down(void) {
-    if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) != pdTRUE) {
+static void config_load(poofer_config_t* out) {
+    *out = config_defaults;
+
+    nvs_handle_t nvs;
+    if (nvs_open(CONFIG_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return;
+    }
+    poofer_config_t stored = config_defaults;
+    size_t size = sizeof(stored);
+    esp_err_t err = nvs_get_blob(nvs, CONFIG_NVS_KEY, &stored, &size);
+    nvs_close(nvs);
+    if (err != ESP_OK) {
+        if (err != ESP_ERR_NVS_NOT_FOUND) {
+            ESP_LOGW(TAG, "Config blob unreadable (%s), using defaults", esp_err_to_name(err));
+        }
         return;
     }
 
-    if (runtime.state == STATE_ERROR || runtime.press_active ||
-        runtime.press_ignore_until_release) {
-        xSemaphoreGive(state_lock);
+    if (size < offsetof(poofer_config_t, min_hold_ms) || stored.version == 0 ||
+        stored.version > CONFIG_VERSION || stored.size != size) {
+        ESP_LOGW(TAG, "Config blob v%u (%u bytes) not supported, using defaults",
+                 (unsigned)stored.version, (unsigned)size);
+        return;
+    }
+    // Go by the version, not the size: a new field can land in the old layout's tail padding
+    // (v2's stream_hz sits in v1's, both are 152 bytes), so it would load padding bytes.
+    if (stored.version < 2) {
+        stored.stream_hz = config_defaults.stream_hz;
+    }
+    if (stored.version < 3) {
+        stored.trigger_gpio = config_defaults.trigger_gpio;
+        stored.trigger_debounce_ms = config_defaults.trigger_debounce_ms;
+    }
+    if (config_validate(&stored) != ESP_OK) {
+        ESP_LOGW(TAG, "Stored config failed validation, using defaults");
         return;
     }
+    *out = stored;
+}
 
-    start_firing_locked();
+static esp_err_t config_store(const poofer_config_t* values) {
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(CONFIG_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_set_blob(nvs, CONFIG_NVS_KEY, values, sizeof(*values));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return err;
+}
 
-    esp_timer_stop(max_hold_timer);
-    esp_timer_start_once(max_hold_timer, (uint64_t)MAX_HOLD_MS * 1000ULL);
+static fire_config_t fire_config_from_slot(const config_slot_t* slot) {
+    fire_config_t fire_config = {
+        .min_hold_ms = slot->values.min_hold_ms,
+        .max_hold_ms = slot->values.max_hold_ms,
+        .link_timeout_ms = slot->values.link_timeout_ms,
+        .frames = slot->solenoid_frames,
+        .frame_count = slot->solenoid_frame_count,
+    };
+    return fire_config;
+}
 
-    esp_timer_stop(solenoid_kick_timer);
-    esp_timer_start_once(solenoid_kick_timer, (uint64_t)SOLENOID_KICK_MS * 1000ULL);
+static void config_swap_pending_locked(void) {
+    if (config_pending && !runtime.fire.active) {
+        config = config_pending;
+        config_pending = NULL;
+        fire_config_t fire_config = fire_config_from_slot(config);
+        fire_control_set_config(&runtime.fire, &fire_config);
+    }
+}
 
+// Validates and persists a complete config, then builds it into the inactive slot and swaps it
+// in, deferring the swap to the end of the current press if one is in flight. The set is stored
+// first so a failed write leaves the running config untouched: what is live is always what the
+// next boot loads.
+static esp_err_t config_apply(const poofer_config_t* values) {
+    esp_err_t err = config_validate(values);
+    if (err != ESP_OK) {
+        return err;
+    }
+    poofer_config_t stored = *values;
+    stored.version = CONFIG_VERSION;
+    stored.size = sizeof(stored);
+    err = config_store(&stored);
+    if (err != ESP_OK) {
+        return err;
+    }
+    // Once stored, the swap must happen. Every holder of the lock only keeps it briefly, so
+    // waiting here cannot stall the HTTP server for long.
+    xSemaphoreTake(state_lock, portMAX_DELAY);
+    config_slot_t* next = (config == &config_slots[0]) ? &config_slots[1] : &config_slots[0];
+    config_slot_build(next, &stored);
+    config_pending = next;
+    config_swap_pending_locked();
     xSemaphoreGive(state_lock);
-    send_state_async();
+    return ESP_OK;
 }
 
-static void handle_press_up(void) {
+static bool config_snapshot(poofer_config_t* out) {
     if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) != pdTRUE) {
-        return;
+        return false;
     }
+    *out = config_pending ? config_pending->values : config->values;
+    xSemaphoreGive(state_lock);
+    return true;
+}
 
-    if (runtime.press_ignore_until_release) {
-        runtime.press_ignore_until_release = false;
-    }
+static void update_status_led_locked(void) {
+    system_state_t state = runtime.state < STATE_COUNT ? runtime.state : STATE_ERROR;
+    const status_color_t* color = &config->values.status_colors[state];
+    runtime.status_r = color->r;
+    runtime.status_g = color->g;
+    runtime.status_b = color->b;
+    refresh_pixels_locked();
+}
 
-    if (!runtime.press_active) {
+static void request_state_push(void) {
+    if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) == pdTRUE) {
+        runtime.push_pending = true;
         xSemaphoreGive(state_lock);
-        return;
     }
+}
 
-    int64_t now = esp_timer_get_time();
-    uint32_t held_ms = 0;
-    if (now > runtime.press_start_us) {
-        held_ms = (uint32_t)((now - runtime.press_start_us) / 1000);
+static void ws_clients_add(int fd) {
+    taskENTER_CRITICAL(&ws_clients_mux);
+    int slot = -1;
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (ws_clients[i].fd == fd) {
+            slot = i;
+            break;
+        }
+        if (slot < 0 && ws_clients[i].fd < 0) {
+            slot = i;
+        }
     }
-
-    runtime.last_hold_ms = clamp_hold_ms(held_ms);
-
-    if (held_ms < MIN_HOLD_MS) {
-        runtime.release_pending = true;
-        esp_timer_stop(min_hold_timer);
-        esp_timer_start_once(min_hold_timer, (uint64_t)(MIN_HOLD_MS - held_ms) * 1000ULL);
-        xSemaphoreGive(state_lock);
-        send_state_async();
-        return;
+    if (slot < 0) {
+        // Table full of sessions the server has not closed yet; the newest controller wins.
+        slot = 0;
     }
+    ws_clients[slot].fd = fd;
+    ws_clients[slot].inflight = 0;
+    ws_clients[slot].stale = false;
+    taskEXIT_CRITICAL(&ws_clients_mux);
+}
 
-    stop_firing_locked(STATE_READY);
+static void ws_clients_remove(int fd) {
+    taskENTER_CRITICAL(&ws_clients_mux);
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (ws_clients[i].fd == fd) {
+            ws_clients[i].fd = -1;
+            ws_clients[i].inflight = 0;
+            ws_clients[i].stale = false;
+        }
+    }
+    taskEXIT_CRITICAL(&ws_clients_mux);
+}
 
-    esp_timer_stop(max_hold_timer);
-    esp_timer_stop(min_hold_timer);
+// Frees one in-flight slot of fd. With retry set the frame never left the device, so the client
+// is marked stale and gets the newest frame on the next tick.
+static void ws_clients_release(int fd, bool retry) {
+    taskENTER_CRITICAL(&ws_clients_mux);
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (ws_clients[i].fd == fd) {
+            if (ws_clients[i].inflight > 0) {
+                ws_clients[i].inflight--;
+            }
+            ws_clients[i].stale = ws_clients[i].stale || retry;
+        }
+    }
+    taskEXIT_CRITICAL(&ws_clients_mux);
+}
 
-    xSemaphoreGive(state_lock);
-    send_state_async();
+// Runs on the httpd task with the result of the socket send, so an error means the session is
+// gone or its socket failed.
+static void ws_send_done(esp_err_t err, int fd, void* arg) {
+    free(arg);
+    ws_clients_release(fd, false);
+    if (err != ESP_OK) {
+        ws_clients_remove(fd);
+    }
 }
 
-static void handle_ws_message(const char* msg) {
-    if (!msg) {
+// Queues one copy of the payload per client on the httpd task. Clients that still have
+// WS_MAX_INFLIGHT frames queued are skipped for this tick rather than buffered further, and are
+// marked stale so a later tick sends them the newest frame. WS_SEND_STATE_STALE only sends to
+// those clients. A frame that cannot be queued (no memory, httpd work queue full) is a local
+// failure and also only marks the client stale; the session itself is still fine. Probes are
+// skipped the same way but leave the stale flag alone, so they cannot stand in for a state frame.
+static void ws_broadcast(const char* payload, size_t len, ws_send_t kind) {
+    if (!httpd) {
         return;
     }
-
-    int64_t now = esp_timer_get_time();
-    if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) == pdTRUE) {
-        runtime.last_ws_rx_us = now;
-        runtime.ws_connected = true;
-        if (runtime.state == STATE_DISCONNECTED) {
-            runtime.state = STATE_READY;
-            update_status_led_locked();
+    bool state = kind != WS_SEND_PROBE;
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        int fd = -1;
+        taskENTER_CRITICAL(&ws_clients_mux);
+        if (ws_clients[i].fd >= 0 && (kind != WS_SEND_STATE_STALE || ws_clients[i].stale)) {
+            if (ws_clients[i].inflight < WS_MAX_INFLIGHT) {
+                fd = ws_clients[i].fd;
+                ws_clients[i].inflight++;
+                ws_clients[i].stale = ws_clients[i].stale && !state;
+            } else if (state) {
+                ws_clients[i].stale = true;
+                ws_frames_skipped++;
+            }
+        }
+        taskEXIT_CRITICAL(&ws_clients_mux);
+        if (fd < 0) {
+            continue;
         }
-        xSemaphoreGive(state_lock);
-    }
 
-    if (strcmp(msg, "DOWN") == 0) {
-        handle_press_down();
-    } else if (strcmp(msg, "UP") == 0) {
-        handle_press_up();
-    } else if (strcmp(msg, "PING") == 0) {
-        send_state_async();
+        char* copy = malloc(len);
+        esp_err_t err = ESP_ERR_NO_MEM;
+        if (copy) {
+            memcpy(copy, payload, len);
+            httpd_ws_frame_t frame = {
+                .final = true,
+                .fragmented = false,
+                .type = HTTPD_WS_TYPE_TEXT,
+                .payload = (uint8_t*)copy,
+                .len = len,
+            };
+            err = httpd_ws_send_data_async(httpd, fd, &frame, ws_send_done, copy);
+        }
+        if (err != ESP_OK) {
+            free(copy);
+            ws_clients_release(fd, state);
+        }
     }
 }
 
-static esp_err_t ws_handler(httpd_req_t* req) {
-    if (req->method == HTTP_GET) {
-        ws_client_fd = httpd_req_to_sockfd(req);
+// Sends at most one state frame per tick: every tick while firing so clients can render the
+// device's own elapsed time, otherwise only when a transition marked the state dirty.
+static void push_task(void* arg) {
+    (void)arg;
+    TickType_t last_wake = xTaskGetTickCount();
+    uint32_t seq = 0;
+    while (true) {
+        bool send = false;
+        bool ready = false;
+        bool firing = false;
+        bool error = false;
+        bool connected = false;
+        uint32_t elapsed = 0;
+        uint32_t last_hold = 0;
+        uint32_t fire_mj = 0;
+        uint32_t min_hold = 0;
+        uint32_t max_hold = 0;
+        uint32_t period_ms = 1000 / DEFAULT_STREAM_HZ;
+
         if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) == pdTRUE) {
-            runtime.ws_connected = true;
-            runtime.last_ws_rx_us = esp_timer_get_time();
-            if (runtime.state == STATE_DISCONNECTED) {
-                runtime.state = STATE_READY;
-                update_status_led_locked();
-            }
+            period_ms = 1000 / config->values.stream_hz;
+            firing = (runtime.state == STATE_FIRING);
+            send = runtime.push_pending || firing;
+            runtime.push_pending = false;
+            ready = (runtime.state == STATE_READY || runtime.state == STATE_FIRING);
+            error = (runtime.state == STATE_ERROR);
+            connected = runtime.ws_connected;
+            elapsed = fire_control_elapsed_ms(&runtime.fire);
+            last_hold = runtime.fire.last_hold_ms;
+            fire_mj = runtime.last_fire_mj;
+            min_hold = config->values.min_hold_ms;
+            max_hold = config->values.max_hold_ms;
             xSemaphoreGive(state_lock);
         }
-        send_state_async();
-        return ESP_OK;
-    }
 
-    httpd_ws_frame_t frame = {0};
-    frame.type = HTTPD_WS_TYPE_TEXT;
+        // Nothing changed this tick, but a client that missed the last frame still gets the
+        // current state, so a dropped firing:false frame cannot leave its UI showing a burn.
+        bool stale_only = false;
+        if (!send) {
+            taskENTER_CRITICAL(&ws_clients_mux);
+            for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+                stale_only = stale_only || (ws_clients[i].fd >= 0 && ws_clients[i].stale);
+            }
+            taskEXIT_CRITICAL(&ws_clients_mux);
+            send = stale_only;
+        }
 
-    esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
-    if (err != ESP_OK || frame.len == 0) {
-        return err;
-    }
+        if (send) {
+            char payload[256];
+            int len = snprintf(payload, sizeof(payload),
+                               "{\"seq\":%" PRIu32 ",\"ready\":%s,\"firing\":%s,\"error\":%s,"
+                               "\"connected\":%s,\"elapsed_ms\":%" PRIu32
+                               ",\"last_hold_ms\":%" PRIu32 ",\"fire_mj\":%" PRIu32
+                               ",\"min_hold_ms\":%" PRIu32 ",\"max_hold_ms\":%" PRIu32 "%s%s%s}",
+                               ++seq, ready ? "true" : "false", firing ? "true" : "false",
+                               error ? "true" : "false", connected ? "true" : "false", elapsed,
+                               last_hold, fire_mj, min_hold, max_hold,
+                               boot_report.fault ? ",\"fault\":\"" : "",
+                               boot_report.fault ? boot_report.fault : "",
+                               boot_report.fault ? "\"" : "");
+            if (len > 0 && len < (int)sizeof(payload)) {
+                ws_broadcast(payload, (size_t)len,
+                             stale_only ? WS_SEND_STATE_STALE : WS_SEND_STATE);
+                uint8_t flags = (ready ? CAPTURE_FLAG_READY : 0) |
+                                (firing ? CAPTURE_FLAG_FIRING : 0) |
+                                (error ? CAPTURE_FLAG_ERROR : 0) |
+                                (connected ? CAPTURE_FLAG_CONNECTED : 0);
+                capture_record(CAPTURE_TX_STATE, flags, NULL, elapsed, last_hold);
+            }
+        }
 
-    char* buf = calloc(1, frame.len + 1);
-    if (!buf) {
-        return ESP_ERR_NO_MEM;
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(period_ms));
     }
+}
 
-    frame.payload = (uint8_t*)buf;
-    err = httpd_ws_recv_frame(req, &frame, frame.len);
-    if (err == ESP_OK) {
-        handle_ws_message(buf);
+static int64_t fire_now_us(void* ctx) {
+    (void)ctx;
+    return esp_timer_get_time();
+}
+
+static void fire_set_levels(void* ctx, const uint8_t* level) {
+    (void)ctx;
+    refresh_pixels_locked();
+    capture_record(CAPTURE_SOLENOID, 0, level, 0, 0);
+}
+
+static esp_timer_handle_t fire_timer_handle(fire_timer_t timer) {
+    switch (timer) {
+    case FIRE_TIMER_FRAME:
+        return solenoid_kick_timer;
+    case FIRE_TIMER_MIN_HOLD:
+        return min_hold_timer;
+    default:
+        return max_hold_timer;
     }
+}
 
-    free(buf);
-    return err;
+static void fire_timer_start(void* ctx, fire_timer_t timer, int64_t delay_us) {
+    (void)ctx;
+    esp_timer_handle_t handle = fire_timer_handle(timer);
+    esp_timer_stop(handle);
+    esp_timer_start_once(handle, (uint64_t)delay_us);
 }
 
-static esp_err_t send_file(httpd_req_t* req, const char* path, const char* content_type) {
-    FILE* file = fopen(path, "r");
-    if (!file) {
-        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "File not found");
+static void fire_timer_stop(void* ctx, fire_timer_t timer) {
+    (void)ctx;
+    esp_timer_stop(fire_timer_handle(timer));
+}
+
+static void fire_on_start(void* ctx) {
+    (void)ctx;
+    runtime.state = STATE_FIRING;
+    crash_record_update_locked();
+    update_status_led_locked();
+
+    // Wake the status task so a running scan is aborted now rather than on its next tick.
+    taskENTER_CRITICAL(&wifi_scan_mux);
+    bool scanning = wifi_scan.active;
+    taskEXIT_CRITICAL(&wifi_scan_mux);
+    if (scanning && status_task_handle) {
+        xTaskNotifyGive(status_task_handle);
+    }
+}
+
+static void fire_on_stop(void* ctx, fire_stop_t reason, uint32_t fired_ms) {
+    (void)ctx;
+    runtime.last_fire_mj =
+        solenoid_energy_mj(config->solenoid_frames, config->solenoid_frame_count,
+                           config->values.solenoid_profiles, fired_ms);
+    if (reason == FIRE_STOP_LINK) {
+        runtime.ws_connected = false;
+    }
+    // A trigger fire can end with no controller attached.
+    runtime.state = runtime.ws_connected ? STATE_READY : STATE_DISCONNECTED;
+    crash_record_update_locked();
+    config_swap_pending_locked();
+    update_status_led_locked();
+}
+
+static const fire_hooks_t fire_hooks = {
+    .now_us = fire_now_us,
+    .set_levels = fire_set_levels,
+    .timer_start = fire_timer_start,
+    .timer_stop = fire_timer_stop,
+    .on_start = fire_on_start,
+    .on_stop = fire_on_stop,
+    .ctx = NULL,
+};
+
+static void fire_timer_expired(fire_timer_t timer) {
+    if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) != pdTRUE) {
+        return;
+    }
+    fire_control_timer_expired(&runtime.fire, timer);
+    xSemaphoreGive(state_lock);
+}
+
+static void max_hold_timer_cb(void* arg) {
+    (void)arg;
+    fire_timer_expired(FIRE_TIMER_MAX_HOLD);
+    request_state_push();
+}
+
+static void min_hold_timer_cb(void* arg) {
+    (void)arg;
+    fire_timer_expired(FIRE_TIMER_MIN_HOLD);
+    request_state_push();
+}
+
+static void solenoid_kick_timer_cb(void* arg) {
+    (void)arg;
+    fire_timer_expired(FIRE_TIMER_FRAME);
+}
+
+static bool handle_press_down(press_source_t source) {
+    if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) != pdTRUE) {
+        return false;
+    }
+
+    if (runtime.state == STATE_ERROR) {
+        xSemaphoreGive(state_lock);
+        return false;
+    }
+
+    int64_t cost_start_us = esp_timer_get_time();
+    bool started = fire_control_press_down(&runtime.fire, source);
+    if (started) {
+        runtime.press_cost_us = (uint32_t)(esp_timer_get_time() - cost_start_us);
+        if (runtime.press_cost_us > runtime.press_cost_max_us) {
+            runtime.press_cost_max_us = runtime.press_cost_us;
+        }
+    }
+
+    xSemaphoreGive(state_lock);
+    if (started) {
+        request_state_push();
+    }
+    return started;
+}
+
+static void handle_press_up(press_source_t source) {
+    if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) != pdTRUE) {
+        return;
+    }
+
+    bool owned = runtime.fire.active && runtime.fire.source == source;
+    fire_control_press_up(&runtime.fire, source);
+
+    xSemaphoreGive(state_lock);
+    if (owned) {
+        request_state_push();
+    }
+}
+
+static void latency_stats_add(latency_stats_t* stats, uint32_t us) {
+    if (stats->count == 0 || us < stats->min_us) {
+        stats->min_us = us;
+    }
+    if (us > stats->max_us) {
+        stats->max_us = us;
+    }
+    stats->total_us += us;
+    stats->count++;
+}
+
+// Only the first ACK of the probe still outstanding counts, so with several controllers the
+// sample is the fastest round trip. Round trips that overlapped a scan are kept apart, so the
+// cost of scanning on the control link can be compared against the idle baseline.
+static void link_probe_ack(const char* seq_text, int64_t now) {
+    char* end = NULL;
+    uint32_t seq = (uint32_t)strtoul(seq_text, &end, 10);
+    if (end == seq_text || *end != '\0') {
+        return;
+    }
+    taskENTER_CRITICAL(&wifi_scan_mux);
+    int64_t scan_end_us = wifi_scan.active ? now : wifi_scan.done_us;
+    taskEXIT_CRITICAL(&wifi_scan_mux);
+    if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) != pdTRUE) {
+        return;
+    }
+    if (runtime.link_probe_pending && seq == runtime.link_probe_seq) {
+        runtime.link_probe_pending = false;
+        uint32_t rtt_us = (uint32_t)(now - runtime.link_probe_sent_us);
+        latency_stats_add(scan_end_us > runtime.link_probe_sent_us ? &runtime.link_rtt_scan
+                                                                   : &runtime.link_rtt_idle,
+                          rtt_us);
+    }
+    xSemaphoreGive(state_lock);
+}
+
+static void handle_ws_message(const char* msg) {
+    if (!msg) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) == pdTRUE) {
+        runtime.last_ws_rx_us = now;
+        runtime.ws_connected = true;
+        if (runtime.state == STATE_DISCONNECTED) {
+            runtime.state = STATE_READY;
+            runtime.push_pending = true;
+            update_status_led_locked();
+        }
+        xSemaphoreGive(state_lock);
+    }
+
+    if (strcmp(msg, "DOWN") == 0) {
+        handle_press_down(PRESS_SOURCE_WS);
+    } else if (strcmp(msg, "UP") == 0) {
+        handle_press_up(PRESS_SOURCE_WS);
+    } else if (strcmp(msg, "PING") == 0) {
+        request_state_push();
+    } else if (strncmp(msg, "ACK ", 4) == 0) {
+        link_probe_ack(msg + 4, now);
+    }
+}
+
+static esp_err_t ws_handler(httpd_req_t* req) {
+    if (req->method == HTTP_GET) {
+        ws_clients_add(httpd_req_to_sockfd(req));
+        capture_record(CAPTURE_WS_OPEN, 0, NULL, 0, 0);
+        if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) == pdTRUE) {
+            runtime.ws_connected = true;
+            runtime.last_ws_rx_us = esp_timer_get_time();
+            if (runtime.state == STATE_DISCONNECTED) {
+                runtime.state = STATE_READY;
+                update_status_led_locked();
+            }
+            xSemaphoreGive(state_lock);
+        }
+        request_state_push();
+        return ESP_OK;
+    }
+
+    httpd_ws_frame_t frame = {0};
+    frame.type = HTTPD_WS_TYPE_TEXT;
+
+    esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+    if (err != ESP_OK || frame.len == 0) {
+        return err;
+    }
+
+    char* buf = calloc(1, frame.len + 1);
+    if (!buf) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    frame.payload = (uint8_t*)buf;
+    err = httpd_ws_recv_frame(req, &frame, frame.len);
+    if (err == ESP_OK) {
+        capture_ws_rx(buf, frame.len);
+        handle_ws_message(buf);
+    }
+
+    free(buf);
+    return err;
+}
+
+static esp_err_t send_file(httpd_req_t* req, const char* path, const char* content_type) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "File not found");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, content_type);
+
+    int fd = fileno(file);
+    if (fd < 0) {
+        fclose(file);
+        httpd_resp_sendstr_chunk(req, NULL);
+        return ESP_FAIL;
+    }
+
+    char buffer[512];
+    for (;;) {
+        ssize_t read_bytes = read(fd, buffer, sizeof(buffer));
+        if (read_bytes > 0) {
+            if (httpd_resp_send_chunk(req, buffer, (size_t)read_bytes) != ESP_OK) {
+                fclose(file);
+                httpd_resp_sendstr_chunk(req, NULL);
+                return ESP_FAIL;
+            }
+            continue;
+        }
+        if (read_bytes < 0) {
+            fclose(file);
+            httpd_resp_sendstr_chunk(req, NULL);
+            return ESP_FAIL;
+        }
+        break;
+    }
+    fclose(file);
+    httpd_resp_sendstr_chunk(req, NULL);
+    return ESP_OK;
+}
+
+static esp_err_t index_handler(httpd_req_t* req) {
+    return send_file(req, "/spiffs/index.html", "text/html");
+}
+
+static esp_err_t wifi_get_handler(httpd_req_t* req) {
+    return send_file(req, "/spiffs/wifi.html", "text/html");
+}
+
+// Decodes src_len bytes of src. Returns false if the decoded value does not fit in dst_len.
+static bool url_decode(char* dst, size_t dst_len, const char* src, size_t src_len) {
+    const char* end = src + src_len;
+    size_t len = 0;
+    while (src < end) {
+        char a, b;
+        if (len + 1 >= dst_len) {
+            dst[len] = '\0';
+            return false;
+        }
+        if ((*src == '%') && end - src >= 3 && ((a = src[1]) && (b = src[2])) &&
+            (isxdigit((int)a) && isxdigit((int)b))) {
+            if (a >= 'a')
+                a -= 'a' - 'A';
+            if (a >= 'A')
+                a -= 'A' - 10;
+            else
+                a -= '0';
+            if (b >= 'a')
+                b -= 'a' - 'A';
+            if (b >= 'A')
+                b -= 'A' - 10;
+            else
+                b -= '0';
+            dst[len++] = (char)(16 * a + b);
+            src += 3;
+        } else if (*src == '+') {
+            dst[len++] = ' ';
+            src++;
+        } else {
+            dst[len++] = *src++;
+        }
+    }
+    dst[len] = '\0';
+    return true;
+}
+
+// ESP_ERR_NOT_FOUND if the key is absent, ESP_ERR_INVALID_SIZE if the decoded value does not fit
+// in out; a cut-down value is never handed back as if it were whole.
+static esp_err_t parse_form_value(const char* body, const char* key, char* out, size_t out_len) {
+    if (!body || !key || !out || out_len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Match whole keys only, so "pass" does not pick up "ap_pass".
+    size_t key_len = strlen(key);
+    const char* start = body;
+    while (start && !(strncmp(start, key, key_len) == 0 && start[key_len] == '=')) {
+        start = strchr(start, '&');
+        if (start) {
+            start++;
+        }
+    }
+    if (!start) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    start += key_len + 1;
+    const char* end = strchr(start, '&');
+    size_t len = end ? (size_t)(end - start) : strlen(start);
+    return url_decode(out, out_len, start, len) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+static void wifi_store_credentials(const char* ssid, const char* pass) {
+    nvs_handle_t nvs;
+    if (nvs_open("wifi", NVS_READWRITE, &nvs) != ESP_OK) {
+        return;
+    }
+    if (ssid && ssid[0]) {
+        nvs_set_str(nvs, "ssid", ssid);
+    }
+    if (pass) {
+        nvs_set_str(nvs, "pass", pass);
+    }
+    nvs_commit(nvs);
+    nvs_close(nvs);
+}
+
+static bool wifi_load_credentials(char* ssid_out, size_t ssid_len, char* pass_out,
+                                  size_t pass_len) {
+    nvs_handle_t nvs;
+    if (nvs_open("wifi", NVS_READONLY, &nvs) != ESP_OK) {
+        return false;
+    }
+    size_t ssid_size = ssid_len;
+    size_t pass_size = pass_len;
+    esp_err_t ssid_err = nvs_get_str(nvs, "ssid", ssid_out, &ssid_size);
+    esp_err_t pass_err = nvs_get_str(nvs, "pass", pass_out, &pass_size);
+    nvs_close(nvs);
+    return (ssid_err == ESP_OK && ssid_out[0] != '\0') && (pass_err == ESP_OK);
+}
+
+static void wifi_connect_sta(void) {
+    char ssid[33] = {0};
+    char pass[65] = {0};
+    if (!wifi_load_credentials(ssid, sizeof(ssid), pass, sizeof(pass))) {
+        ESP_LOGI(TAG, "No STA credentials stored");
+        return;
+    }
+
+    wifi_config_t sta_config = {0};
+    strncpy((char*)sta_config.sta.ssid, ssid, sizeof(sta_config.sta.ssid));
+    strncpy((char*)sta_config.sta.password, pass, sizeof(sta_config.sta.password));
+    sta_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+    sta_config.sta.pmf_cfg.capable = true;
+    sta_config.sta.pmf_cfg.required = false;
+
+    esp_wifi_set_config(WIFI_IF_STA, &sta_config);
+    esp_wifi_connect();
+}
+
+static esp_err_t wifi_post_handler(httpd_req_t* req) {
+    int total_len = req->content_len;
+    if (total_len <= 0 || total_len > 512) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid content");
+        return ESP_FAIL;
+    }
+
+    char* buf = calloc(1, total_len + 1);
+    if (!buf) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OOM");
+        return ESP_FAIL;
+    }
+
+    int received = httpd_req_recv(req, buf, total_len);
+    if (received <= 0) {
+        free(buf);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Recv fail");
+        return ESP_FAIL;
+    }
+    buf[received] = '\0';
+
+    char ssid[33] = {0};
+    char pass[65] = {0};
+    esp_err_t ssid_err = parse_form_value(buf, "ssid", ssid, sizeof(ssid));
+    esp_err_t pass_err = parse_form_value(buf, "pass", pass, sizeof(pass));
+
+    free(buf);
+
+    if (ssid_err == ESP_ERR_INVALID_SIZE || pass_err == ESP_ERR_INVALID_SIZE) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "SSID or password too long");
+        return ESP_FAIL;
+    }
+
+    if (ssid[0] == '\0') {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "SSID required");
+        return ESP_FAIL;
+    }
+
+    wifi_store_credentials(ssid, pass);
+    wifi_connect_sta();
+
+    httpd_resp_set_type(req, "text/html");
+    httpd_resp_sendstr(
+        req, "<html><body><h2>Saved. Reconnecting...</h2><a href=\"/\">Back</a></body></html>");
+    return ESP_OK;
+}
+
+// Control characters are replaced rather than escaped; UTF-8 bytes pass through.
+static size_t json_append_string(char* out, size_t len, size_t out_len, const char* str) {
+    if (len + 2 >= out_len) {
+        return len;
+    }
+    out[len++] = '"';
+    for (const char* c = str; *c && len + 3 < out_len; c++) {
+        unsigned char ch = (unsigned char)*c;
+        if (ch == '"' || ch == '\\') {
+            out[len++] = '\\';
+        }
+        out[len++] = (ch < 0x20 || ch == 0x7f) ? '?' : (char)ch;
+    }
+    out[len++] = '"';
+    out[len] = '\0';
+    return len;
+}
+
+// Keeps one entry per SSID at its strongest RSSI. When the table is full the weakest entry
+// gives way to a stronger one.
+static void wifi_scan_table_insert(wifi_scan_entry_t* table, size_t* count,
+                                   const wifi_ap_record_t* record) {
+    const char* ssid = (const char*)record->ssid;
+    if (ssid[0] == '\0') {
+        return;
+    }
+
+    size_t slot = *count;
+    for (size_t i = 0; i < *count; i++) {
+        if (strcmp(table[i].ssid, ssid) == 0) {
+            if (record->rssi <= table[i].rssi) {
+                return;
+            }
+            slot = i;
+            break;
+        }
+    }
+    if (slot == WIFI_SCAN_TABLE_SIZE) {
+        slot = 0;
+        for (size_t i = 1; i < *count; i++) {
+            if (table[i].rssi < table[slot].rssi) {
+                slot = i;
+            }
+        }
+        if (record->rssi <= table[slot].rssi) {
+            return;
+        }
+    } else if (slot == *count) {
+        (*count)++;
+    }
+
+    wifi_scan_entry_t* entry = &table[slot];
+    strncpy(entry->ssid, ssid, sizeof(entry->ssid) - 1);
+    entry->ssid[sizeof(entry->ssid) - 1] = '\0';
+    entry->rssi = record->rssi;
+    entry->channel = record->primary;
+    entry->secure = record->authmode != WIFI_AUTH_OPEN;
+}
+
+// Runs on the event loop task for every WIFI_EVENT_SCAN_DONE, so the record copy and dedup never
+// hold up httpd. A scan aborted for a press counts as failed and keeps the previous table.
+static void wifi_scan_finish(bool success) {
+    static wifi_ap_record_t records[WIFI_SCAN_MAX_RECORDS];
+    static wifi_scan_entry_t table[WIFI_SCAN_TABLE_SIZE];
+
+    taskENTER_CRITICAL(&wifi_scan_mux);
+    bool active = wifi_scan.active;
+    success = success && !wifi_scan.aborted;
+    taskEXIT_CRITICAL(&wifi_scan_mux);
+    if (!active) {
+        // Not a scan wifi_scan_poll started; only free the driver's copy of the results.
+        esp_wifi_clear_ap_list();
+        return;
+    }
+
+    uint16_t number = WIFI_SCAN_MAX_RECORDS;
+    if (!success || esp_wifi_scan_get_ap_records(&number, records) != ESP_OK) {
+        esp_wifi_clear_ap_list();
+        success = false;
+        number = 0;
+    }
+
+    size_t count = 0;
+    for (uint16_t i = 0; i < number; i++) {
+        wifi_scan_table_insert(table, &count, &records[i]);
+    }
+    for (size_t i = 1; i < count; i++) {
+        wifi_scan_entry_t entry = table[i];
+        size_t j = i;
+        for (; j > 0 && table[j - 1].rssi < entry.rssi; j--) {
+            table[j] = table[j - 1];
+        }
+        table[j] = entry;
+    }
+
+    int64_t now = esp_timer_get_time();
+    uint32_t duration_ms = 0;
+    taskENTER_CRITICAL(&wifi_scan_mux);
+    if (wifi_scan.active) {
+        wifi_scan.active = false;
+        wifi_scan.aborted = false;
+        wifi_scan.done_us = now;
+        duration_ms = (uint32_t)((now - wifi_scan.started_us) / 1000);
+        wifi_scan.duration_ms = duration_ms;
+        if (success) {
+            memcpy(wifi_scan.entries, table, count * sizeof(table[0]));
+            wifi_scan.count = count;
+            wifi_scan.scans++;
+        } else {
+            wifi_scan.failures++;
+        }
+    }
+    taskEXIT_CRITICAL(&wifi_scan_mux);
+    capture_record(CAPTURE_SCAN_DONE, 0, NULL, (uint32_t)count, duration_ms);
+}
+
+// Called from the status task. The scan itself is non-blocking; completion arrives as
+// WIFI_EVENT_SCAN_DONE. A scan still running when a press starts is aborted so the radio stays
+// on the AP channel for the rest of the burn. The driver posts WIFI_EVENT_SCAN_DONE for an
+// aborted scan too, so the event handler finishes it either way.
+static void wifi_scan_poll(bool firing, bool controller) {
+    int64_t now = esp_timer_get_time();
+    bool start = false;
+    bool abort = false;
+    taskENTER_CRITICAL(&wifi_scan_mux);
+    if (wifi_scan.active) {
+        abort = firing && !wifi_scan.aborted;
+        wifi_scan.aborted = wifi_scan.aborted || abort;
+    } else if (!firing) {
+        // After a crash the boot scan is skipped so the radio stays on the AP channel while
+        // controllers reconnect.
+        bool due = (wifi_scan.started_us == 0 && !boot_report.fault) ||
+                   (!controller && now - wifi_scan.started_us >= WIFI_SCAN_PERIOD_MS * 1000LL);
+        if (wifi_scan.requested || due) {
+            wifi_scan.requested = false;
+            wifi_scan.active = true;
+            wifi_scan.started_us = now;
+            start = true;
+        }
+    }
+    taskEXIT_CRITICAL(&wifi_scan_mux);
+
+    if (abort) {
+        esp_wifi_scan_stop();
+        ESP_LOGI(TAG, "Wi-Fi scan aborted for a press");
+        return;
+    }
+    if (!start) {
+        return;
+    }
+
+    wifi_scan_config_t scan_config = {
+        .show_hidden = false,
+        .scan_type = WIFI_SCAN_TYPE_ACTIVE,
+        .scan_time.active.min = 0,
+        .scan_time.active.max = WIFI_SCAN_CHANNEL_MS,
+        .home_chan_dwell_time = WIFI_SCAN_HOME_DWELL_MS,
+    };
+    esp_err_t err = esp_wifi_scan_start(&scan_config, false);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Wi-Fi scan start failed: %s", esp_err_to_name(err));
+        taskENTER_CRITICAL(&wifi_scan_mux);
+        wifi_scan.active = false;
+        wifi_scan.failures++;
+        taskEXIT_CRITICAL(&wifi_scan_mux);
+        return;
+    }
+    capture_record(CAPTURE_SCAN_START, 0, NULL, 0, 0);
+}
+
+// Serves the cached table and never waits on the radio. `refresh=1` asks the status task for a
+// new scan, at most once per WIFI_SCAN_MIN_INTERVAL_MS.
+static esp_err_t wifi_scan_get_handler(httpd_req_t* req) {
+    char query[32] = {0};
+    char refresh[4] = {0};
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        parse_form_value(query, "refresh", refresh, sizeof(refresh)); // absent or bad: no refresh
+    }
+
+    wifi_scan_entry_t* entries = calloc(WIFI_SCAN_TABLE_SIZE, sizeof(wifi_scan_entry_t));
+    size_t out_len = 96 + WIFI_SCAN_TABLE_SIZE * (2 * sizeof(entries[0].ssid) + 24);
+    char* out = malloc(out_len);
+    if (!entries || !out) {
+        free(entries);
+        free(out);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OOM");
+        return ESP_FAIL;
+    }
+
+    int64_t now = esp_timer_get_time();
+    taskENTER_CRITICAL(&wifi_scan_mux);
+    if (strcmp(refresh, "1") == 0 && !wifi_scan.active &&
+        (wifi_scan.started_us == 0 ||
+         now - wifi_scan.started_us >= WIFI_SCAN_MIN_INTERVAL_MS * 1000LL)) {
+        wifi_scan.requested = true;
+    }
+    bool scanning = wifi_scan.active || wifi_scan.requested;
+    int64_t done_us = wifi_scan.done_us;
+    uint32_t duration_ms = wifi_scan.duration_ms;
+    size_t count = wifi_scan.count;
+    memcpy(entries, wifi_scan.entries, count * sizeof(entries[0]));
+    taskEXIT_CRITICAL(&wifi_scan_mux);
+
+    long long age_ms = done_us ? (now - done_us) / 1000 : -1;
+    size_t len = (size_t)snprintf(out, out_len, "{\"scanning\":%s,\"age_ms\":%lld,"
+                                  "\"scan_ms\":%" PRIu32 ",\"aps\":[",
+                                  scanning ? "true" : "false", age_ms, duration_ms);
+    for (size_t i = 0; i < count && len + 48 < out_len; i++) {
+        len += (size_t)snprintf(out + len, out_len - len, "%s[", i ? "," : "");
+        len = json_append_string(out, len, out_len, entries[i].ssid);
+        len += (size_t)snprintf(out + len, out_len - len, ",%d,%u,%d]", entries[i].rssi,
+                                entries[i].channel, entries[i].secure ? 1 : 0);
+    }
+    len += (size_t)snprintf(out + len, out_len - len, "]}");
+    free(entries);
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    esp_err_t err = httpd_resp_send(req, out, (ssize_t)len);
+    free(out);
+    return err;
+}
+
+typedef enum {
+    CONFIG_FIELD_UINT,
+    CONFIG_FIELD_INT,
+    CONFIG_FIELD_STRING,
+    CONFIG_FIELD_SECRET,
+    CONFIG_FIELD_COLOR,
+} config_field_type_t;
+
+typedef struct {
+    const char* key;
+    config_field_type_t type;
+    size_t offset;
+    size_t size;
+} config_field_t;
+
+#define CONFIG_FIELD(key, type, member)                                                            \
+    {key, type, offsetof(poofer_config_t, member), sizeof(((poofer_config_t*)0)->member)}
+#define CONFIG_PROFILE_FIELDS(prefix, ch)                                                          \
+    CONFIG_FIELD(prefix "_kick_level", CONFIG_FIELD_UINT, solenoid_profiles[ch].kick_level),      \
+        CONFIG_FIELD(prefix "_kick_ms", CONFIG_FIELD_UINT, solenoid_profiles[ch].kick_ms),         \
+        CONFIG_FIELD(prefix "_hold_level", CONFIG_FIELD_UINT, solenoid_profiles[ch].hold_level),   \
+        CONFIG_FIELD(prefix "_decay_steps", CONFIG_FIELD_UINT, solenoid_profiles[ch].decay_steps), \
+        CONFIG_FIELD(prefix "_decay_step_ms", CONFIG_FIELD_UINT,                                   \
+                     solenoid_profiles[ch].decay_step_ms),                                         \
+        CONFIG_FIELD(prefix "_coil_ma", CONFIG_FIELD_UINT, solenoid_profiles[ch].coil_ma)
+
+static const config_field_t config_fields[] = {
+    CONFIG_FIELD("min_hold_ms", CONFIG_FIELD_UINT, min_hold_ms),
+    CONFIG_FIELD("max_hold_ms", CONFIG_FIELD_UINT, max_hold_ms),
+    CONFIG_FIELD("link_timeout_ms", CONFIG_FIELD_UINT, link_timeout_ms),
+    CONFIG_FIELD("ap_ssid", CONFIG_FIELD_STRING, ap_ssid),
+    CONFIG_FIELD("ap_pass", CONFIG_FIELD_SECRET, ap_pass),
+    CONFIG_FIELD("color_boot", CONFIG_FIELD_COLOR, status_colors[STATE_BOOT]),
+    CONFIG_FIELD("color_ready", CONFIG_FIELD_COLOR, status_colors[STATE_READY]),
+    CONFIG_FIELD("color_firing", CONFIG_FIELD_COLOR, status_colors[STATE_FIRING]),
+    CONFIG_FIELD("color_disconnected", CONFIG_FIELD_COLOR, status_colors[STATE_DISCONNECTED]),
+    CONFIG_FIELD("color_error", CONFIG_FIELD_COLOR, status_colors[STATE_ERROR]),
+    CONFIG_PROFILE_FIELDS("ch1", 0),
+    CONFIG_PROFILE_FIELDS("ch2", 1),
+    CONFIG_FIELD("stream_hz", CONFIG_FIELD_UINT, stream_hz),
+    CONFIG_FIELD("trigger_gpio", CONFIG_FIELD_INT, trigger_gpio),
+    CONFIG_FIELD("trigger_debounce_ms", CONFIG_FIELD_UINT, trigger_debounce_ms),
+};
+
+static uint32_t config_field_get_uint(const poofer_config_t* values, const config_field_t* field) {
+    const uint8_t* ptr = (const uint8_t*)values + field->offset;
+    switch (field->size) {
+    case sizeof(uint8_t):
+        return *ptr;
+    case sizeof(uint16_t):
+        return *(const uint16_t*)ptr;
+    default:
+        return *(const uint32_t*)ptr;
+    }
+}
+
+static bool config_field_set(poofer_config_t* values, const config_field_t* field,
+                             const char* text) {
+    uint8_t* ptr = (uint8_t*)values + field->offset;
+    switch (field->type) {
+    case CONFIG_FIELD_UINT: {
+        char* end = NULL;
+        unsigned long value = strtoul(text, &end, 10);
+        if (end == text || *end != '\0') {
+            return false;
+        }
+        if (field->size == sizeof(uint8_t) && value <= UINT8_MAX) {
+            *ptr = (uint8_t)value;
+        } else if (field->size == sizeof(uint16_t) && value <= UINT16_MAX) {
+            *(uint16_t*)ptr = (uint16_t)value;
+        } else if (field->size == sizeof(uint32_t)) {
+            *(uint32_t*)ptr = (uint32_t)value;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    case CONFIG_FIELD_INT: {
+        char* end = NULL;
+        long value = strtol(text, &end, 10);
+        if (end == text || *end != '\0' || field->size != sizeof(int8_t) || value < INT8_MIN ||
+            value > INT8_MAX) {
+            return false;
+        }
+        *(int8_t*)ptr = (int8_t)value;
+        return true;
+    }
+    case CONFIG_FIELD_STRING:
+    case CONFIG_FIELD_SECRET:
+        if (strlen(text) >= field->size) {
+            return false;
+        }
+        strncpy((char*)ptr, text, field->size);
+        return true;
+    case CONFIG_FIELD_COLOR: {
+        if (text[0] == '#') {
+            text++;
+        }
+        char* end = NULL;
+        unsigned long rgb = strtoul(text, &end, 16);
+        if (strlen(text) != 6 || *end != '\0') {
+            return false;
+        }
+        status_color_t* color = (status_color_t*)ptr;
+        color->r = (uint8_t)(rgb >> 16);
+        color->g = (uint8_t)(rgb >> 8);
+        color->b = (uint8_t)rgb;
+        return true;
+    }
+    }
+    return false;
+}
+
+// Writes the config as JSON object members, leaving the object open for the caller to extend.
+static size_t config_to_json(const poofer_config_t* values, char* out, size_t out_len) {
+    size_t len = (size_t)snprintf(out, out_len, "{");
+    for (size_t i = 0; i < sizeof(config_fields) / sizeof(config_fields[0]) && len < out_len;
+         i++) {
+        const config_field_t* field = &config_fields[i];
+        const uint8_t* ptr = (const uint8_t*)values + field->offset;
+        const char* sep = (i == 0) ? "" : ",";
+        switch (field->type) {
+        case CONFIG_FIELD_UINT:
+            len += (size_t)snprintf(out + len, out_len - len, "%s\"%s\":%" PRIu32, sep,
+                                    field->key, config_field_get_uint(values, field));
+            break;
+        case CONFIG_FIELD_INT:
+            len += (size_t)snprintf(out + len, out_len - len, "%s\"%s\":%d", sep, field->key,
+                                    (int)*(const int8_t*)ptr);
+            break;
+        case CONFIG_FIELD_STRING:
+            len += (size_t)snprintf(out + len, out_len - len, "%s\"%s\":", sep, field->key);
+            len = json_append_string(out, len, out_len, (const char*)ptr);
+            break;
+        case CONFIG_FIELD_SECRET:
+            len += (size_t)snprintf(out + len, out_len - len, "%s\"%s\":%s", sep, field->key,
+                                    ((const char*)ptr)[0] ? "\"********\"" : "\"\"");
+            break;
+        case CONFIG_FIELD_COLOR: {
+            const status_color_t* color = (const status_color_t*)ptr;
+            len += (size_t)snprintf(out + len, out_len - len, "%s\"%s\":\"#%02x%02x%02x\"", sep,
+                                    field->key, color->r, color->g, color->b);
+            break;
+        }
+        }
+    }
+    return len;
+}
+
+static size_t latency_stats_json(char* buf, size_t buf_len, const char* name,
+                                 const latency_stats_t* stats) {
+    uint32_t mean_us = stats->count ? (uint32_t)(stats->total_us / stats->count) : 0;
+    int len = snprintf(buf, buf_len,
+                       ",\"%s_count\":%" PRIu32 ",\"%s_min_us\":%" PRIu32
+                       ",\"%s_mean_us\":%" PRIu32 ",\"%s_max_us\":%" PRIu32,
+                       name, stats->count, name, stats->min_us, name, mean_us, name, stats->max_us);
+    return len < 0 ? buf_len : (size_t)len;
+}
+
+static esp_err_t config_send_json(httpd_req_t* req) {
+    poofer_config_t values;
+    uint32_t press_cost_us = 0;
+    uint32_t press_cost_max_us = 0;
+    uint32_t frames_skipped = 0;
+    uint32_t trigger_latency_us = 0;
+    uint32_t trigger_latency_max_us = 0;
+    latency_stats_t rtt_idle = {0};
+    latency_stats_t rtt_scan = {0};
+    uint32_t probes_lost = 0;
+    if (!config_snapshot(&values)) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Busy");
+        return ESP_FAIL;
+    }
+    if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) == pdTRUE) {
+        press_cost_us = runtime.press_cost_us;
+        press_cost_max_us = runtime.press_cost_max_us;
+        trigger_latency_us = runtime.trigger_latency_us;
+        trigger_latency_max_us = runtime.trigger_latency_max_us;
+        rtt_idle = runtime.link_rtt_idle;
+        rtt_scan = runtime.link_rtt_scan;
+        probes_lost = runtime.link_probes_lost;
+        xSemaphoreGive(state_lock);
+    }
+    taskENTER_CRITICAL(&ws_clients_mux);
+    frames_skipped = ws_frames_skipped;
+    taskEXIT_CRITICAL(&ws_clients_mux);
+    taskENTER_CRITICAL(&wifi_scan_mux);
+    uint32_t scans = wifi_scan.scans;
+    uint32_t scan_failures = wifi_scan.failures;
+    taskEXIT_CRITICAL(&wifi_scan_mux);
+
+    const size_t buf_len = 1536;
+    char* buf = calloc(1, buf_len);
+    if (!buf) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OOM");
+        return ESP_FAIL;
+    }
+    size_t len = config_to_json(&values, buf, buf_len);
+    if (len < buf_len) {
+        len += (size_t)snprintf(buf + len, buf_len - len,
+                                ",\"press_cost_us\":%" PRIu32
+                                ",\"press_cost_max_us\":%" PRIu32
+                                ",\"ws_frames_skipped\":%" PRIu32
+                                ",\"trigger_latency_us\":%" PRIu32
+                                ",\"trigger_latency_max_us\":%" PRIu32
+                                ",\"link_probes_lost\":%" PRIu32
+                                ",\"wifi_scans\":%" PRIu32 ",\"wifi_scan_failures\":%" PRIu32
+                                ",\"reset_reason\":\"%s\",\"boot_count\":%" PRIu32
+                                ",\"reset_was_firing\":%s,\"reset_fire_ms\":%" PRIu32
+                                ",\"boot_safe_us\":%lld,\"boot_control_ready_us\":%lld",
+                                press_cost_us, press_cost_max_us, frames_skipped,
+                                trigger_latency_us, trigger_latency_max_us, probes_lost, scans,
+                                scan_failures,
+                                reset_reason_name(boot_report.reset_reason),
+                                boot_report.boot_count, boot_report.was_firing ? "true" : "false",
+                                boot_report.fire_ms, (long long)boot_report.safe_us,
+                                (long long)boot_report.control_ready_us);
+    }
+    if (len < buf_len) {
+        len += latency_stats_json(buf + len, buf_len - len, "link_rtt_idle", &rtt_idle);
+    }
+    if (len < buf_len) {
+        len += latency_stats_json(buf + len, buf_len - len, "link_rtt_scan", &rtt_scan);
+    }
+    if (len < buf_len) {
+        len += (size_t)snprintf(buf + len, buf_len - len, "}");
+    }
+    if (len >= buf_len) {
+        free(buf);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Config too large");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    esp_err_t err = httpd_resp_send(req, buf, (ssize_t)len);
+    free(buf);
+    return err;
+}
+
+static esp_err_t config_get_handler(httpd_req_t* req) {
+    return config_send_json(req);
+}
+
+static esp_err_t config_post_handler(httpd_req_t* req) {
+    int total_len = req->content_len;
+    if (total_len <= 0 || total_len > 1024) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid content");
+        return ESP_FAIL;
+    }
+
+    char* buf = calloc(1, total_len + 1);
+    if (!buf) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OOM");
         return ESP_FAIL;
     }
 
-    httpd_resp_set_type(req, content_type);
-
-    int fd = fileno(file);
-    if (fd < 0) {
-        fclose(file);
-        httpd_resp_sendstr_chunk(req, NULL);
+    int received = httpd_req_recv(req, buf, total_len);
+    if (received <= 0) {
+        free(buf);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Recv fail");
         return ESP_FAIL;
     }
+    buf[received] = '\0';
 
-    char buffer[512];
-    for (;;) {
-        ssize_t read_bytes = read(fd, buffer, sizeof(buffer));
-        if (read_bytes > 0) {
-            if (httpd_resp_send_chunk(req, buffer, (size_t)read_bytes) != ESP_OK) {
-                fclose(file);
-                httpd_resp_sendstr_chunk(req, NULL);
-                return ESP_FAIL;
-            }
+    // Start from the current set so a form only needs to carry the fields it changes.
+    poofer_config_t values;
+    if (!config_snapshot(&values)) {
+        free(buf);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Busy");
+        return ESP_FAIL;
+    }
+    // Three times the longest field, so even a fully %XX-escaped value decodes whole and an
+    // over-long one is rejected instead of being cut down to something that still parses.
+    char value[3 * sizeof(values.ap_pass)];
+    for (size_t i = 0; i < sizeof(config_fields) / sizeof(config_fields[0]); i++) {
+        esp_err_t err = parse_form_value(buf, config_fields[i].key, value, sizeof(value));
+        if (err == ESP_ERR_NOT_FOUND) {
             continue;
         }
-        if (read_bytes < 0) {
-            fclose(file);
-            httpd_resp_sendstr_chunk(req, NULL);
+        if (err != ESP_OK || !config_field_set(&values, &config_fields[i], value)) {
+            free(buf);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, config_fields[i].key);
             return ESP_FAIL;
         }
-        break;
     }
-    fclose(file);
-    httpd_resp_sendstr_chunk(req, NULL);
-    return ESP_OK;
-}
-
-static esp_err_t index_handler(httpd_req_t* req) {
-    return send_file(req, "/spiffs/index.html", "text/html");
-}
-
-static esp_err_t wifi_get_handler(httpd_req_t* req) {
-    return send_file(req, "/spiffs/wifi.html", "text/html");
-}
+    free(buf);
 
-static void url_decode(char* dst, const char* src) {
-    char a, b;
-    while (*src) {
-        if ((*src == '%') && ((a = src[1]) && (b = src[2])) &&
-            (isxdigit((int)a) && isxdigit((int)b))) {
-            if (a >= 'a')
-                a -= 'a' - 'A';
-            if (a >= 'A')
-                a -= 'A' - 10;
-            else
-                a -= '0';
-            if (b >= 'a')
-                b -= 'a' - 'A';
-            if (b >= 'A')
-                b -= 'A' - 10;
-            else
-                b -= '0';
-            *dst++ = (char)(16 * a + b);
-            src += 3;
-        } else if (*src == '+') {
-            *dst++ = ' ';
-            src++;
-        } else {
-            *dst++ = *src++;
-        }
+    esp_err_t err = config_apply(&values);
+    if (err == ESP_ERR_INVALID_ARG) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Config out of range");
+        return ESP_FAIL;
     }
-    *dst = '\0';
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Config apply failed: %s", esp_err_to_name(err));
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Config not saved");
+        return ESP_FAIL;
+    }
+    request_state_push();
+    return config_send_json(req);
 }
 
-static void parse_form_value(const char* body, const char* key, char* out, size_t out_len) {
-    if (!body || !key || !out || out_len == 0) {
-        return;
+// Streams the capture as one binary file. Recording is paused while the ring is read out and
+// resumes afterwards, so the file is a consistent snapshot. The ring cannot be freed meanwhile:
+// the HTTP server runs one handler at a time.
+static esp_err_t capture_get_handler(httpd_req_t* req) {
+    bool was_enabled = false;
+    capture_header_t header;
+    size_t head = 0;
+    const capture_record_t* records = NULL;
+    taskENTER_CRITICAL(&capture_mux);
+    was_enabled = capture.enabled;
+    capture.enabled = false;
+    header = capture.header;
+    header.count = (uint32_t)capture.count;
+    head = capture.head;
+    records = capture.records;
+    taskEXIT_CRITICAL(&capture_mux);
+
+    if (!records || memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) != 0) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No capture");
+        return ESP_FAIL;
     }
 
-    const char* start = strstr(body, key);
-    if (!start) {
-        return;
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"poofer.pfcp\"");
+    esp_err_t err = httpd_resp_send_chunk(req, (const char*)&header, sizeof(header));
+    if (err == ESP_OK) {
+        err = httpd_resp_send_chunk(req, (const char*)capture.frames,
+                                    (ssize_t)(header.frame_count * sizeof(capture_frame_t)));
     }
-    start += strlen(key);
-    if (*start != '=') {
-        return;
+
+    // Oldest record first: after a wrap the oldest sits at head.
+    size_t start = (header.count < CAPTURE_RECORDS) ? 0 : head;
+    size_t first = header.count - start;
+    if (err == ESP_OK && first > 0) {
+        err = httpd_resp_send_chunk(req, (const char*)&records[start],
+                                    (ssize_t)(first * sizeof(capture_record_t)));
     }
-    start++;
-    const char* end = strchr(start, '&');
-    size_t len = end ? (size_t)(end - start) : strlen(start);
-    if (len >= out_len) {
-        len = out_len - 1;
+    if (err == ESP_OK && start > 0) {
+        err = httpd_resp_send_chunk(req, (const char*)records,
+                                    (ssize_t)(start * sizeof(capture_record_t)));
     }
+    httpd_resp_sendstr_chunk(req, NULL);
 
-    char temp[128];
-    if (len >= sizeof(temp)) {
-        len = sizeof(temp) - 1;
-    }
-    memcpy(temp, start, len);
-    temp[len] = '\0';
-    url_decode(out, temp);
+    taskENTER_CRITICAL(&capture_mux);
+    capture.enabled = was_enabled;
+    taskEXIT_CRITICAL(&capture_mux);
+    return err;
 }
 
-static void wifi_store_credentials(const char* ssid, const char* pass) {
-    nvs_handle_t nvs;
-    if (nvs_open("wifi", NVS_READWRITE, &nvs) != ESP_OK) {
-        return;
+static esp_err_t capture_post_handler(httpd_req_t* req) {
+    char body[32] = {0};
+    int total_len = req->content_len;
+    if (total_len <= 0 || total_len >= (int)sizeof(body)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid content");
+        return ESP_FAIL;
     }
-    if (ssid && ssid[0]) {
-        nvs_set_str(nvs, "ssid", ssid);
+    int received = httpd_req_recv(req, body, total_len);
+    if (received <= 0) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Recv fail");
+        return ESP_FAIL;
     }
-    if (pass) {
-        nvs_set_str(nvs, "pass", pass);
+    body[received] = '\0';
+
+    char enable[4] = {0};
+    if (parse_form_value(body, "enable", enable, sizeof(enable)) != ESP_OK ||
+        (strcmp(enable, "1") != 0 && strcmp(enable, "0") != 0)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "enable=1 or enable=0 required");
+        return ESP_FAIL;
     }
-    nvs_commit(nvs);
-    nvs_close(nvs);
+    if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) != pdTRUE) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Busy");
+        return ESP_FAIL;
+    }
+    esp_err_t err = capture_set_enabled_locked(enable[0] == '1');
+    xSemaphoreGive(state_lock);
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OOM");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_sendstr(req, enable[0] == '1' ? "{\"capture\":true}"
+                                                     : "{\"capture\":false}");
 }
 
-static bool wifi_load_credentials(char* ssid_out, size_t ssid_len, char* pass_out,
-                                  size_t pass_len) {
-    nvs_handle_t nvs;
-    if (nvs_open("wifi", NVS_READONLY, &nvs) != ESP_OK) {
-        return false;
+// Starts a new round-trip measurement window; the stats in GET /config then cover only the probes
+// answered after it.
+static esp_err_t link_rtt_reset_handler(httpd_req_t* req) {
+    if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) != pdTRUE) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Busy");
+        return ESP_FAIL;
     }
-    size_t ssid_size = ssid_len;
-    size_t pass_size = pass_len;
-    esp_err_t ssid_err = nvs_get_str(nvs, "ssid", ssid_out, &ssid_size);
-    esp_err_t pass_err = nvs_get_str(nvs, "pass", pass_out, &pass_size);
-    nvs_close(nvs);
-    return (ssid_err == ESP_OK && ssid_out[0] != '\0') && (pass_err == ESP_OK);
+    runtime.link_probe_pending = false;
+    runtime.link_probes_lost = 0;
+    memset(&runtime.link_rtt_idle, 0, sizeof(runtime.link_rtt_idle));
+    memset(&runtime.link_rtt_scan, 0, sizeof(runtime.link_rtt_scan));
+    xSemaphoreGive(state_lock);
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_sendstr(req, "{\"ok\":true}");
 }
 
-static void wifi_connect_sta(void) {
-    char ssid[33] = {0};
-    char pass[65] = {0};
-    if (!wifi_load_credentials(ssid, sizeof(ssid), pass, sizeof(pass))) {
-        ESP_LOGI(TAG, "No STA credentials stored");
-        return;
-    }
+#if CONFIG_POOFER_FAULT_INJECT
+static esp_timer_handle_t fault_timer;
+static bool fault_hang;
 
-    wifi_config_t sta_config = {0};
-    strncpy((char*)sta_config.sta.ssid, ssid, sizeof(sta_config.sta.ssid));
-    strncpy((char*)sta_config.sta.password, pass, sizeof(sta_config.sta.password));
-    sta_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
-    sta_config.sta.pmf_cfg.capable = true;
-    sta_config.sta.pmf_cfg.required = false;
+// Runs on the esp_timer task, after the POST /fault reply has been sent.
+static void fault_timer_cb(void* arg) {
+    (void)arg;
+    if (fault_hang) {
+        ESP_LOGW(TAG, "Fault injection: hanging with interrupts off");
+        portDISABLE_INTERRUPTS();
+        while (true) {
+        }
+    }
+    esp_system_abort("fault injection");
+}
 
-    esp_wifi_set_config(WIFI_IF_STA, &sta_config);
-    esp_wifi_connect();
+// Crashes delay_ms from now, with fire set first starting a fire. The fire uses the trigger
+// source because the link timeout only covers WebSocket presses: a last_ws_rx_us left stale by
+// an earlier client would otherwise end the fire within one status tick, before the crash.
+static bool fault_inject_start(bool hang, uint32_t delay_ms, bool fire) {
+    if (fire && !handle_press_down(PRESS_SOURCE_TRIGGER)) {
+        return false;
+    }
+    fault_hang = hang;
+    ESP_LOGW(TAG, "Fault injection: %s in %" PRIu32 " ms", hang ? "hang" : "panic", delay_ms);
+    esp_timer_stop(fault_timer);
+    esp_timer_start_once(fault_timer, (uint64_t)delay_ms * 1000ULL);
+    return true;
 }
 
-static esp_err_t wifi_post_handler(httpd_req_t* req) {
+// Debug builds only: mode=panic|hang crashes the firmware, fire_ms=N first starts a fire and
+// crashes N ms into it. Used by scripts/measure_recovery.py.
+static esp_err_t fault_post_handler(httpd_req_t* req) {
+    char body[64] = {0};
     int total_len = req->content_len;
-    if (total_len <= 0 || total_len > 512) {
+    if (total_len <= 0 || total_len >= (int)sizeof(body)) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid content");
         return ESP_FAIL;
     }
-
-    char* buf = calloc(1, total_len + 1);
-    if (!buf) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OOM");
-        return ESP_FAIL;
-    }
-
-    int received = httpd_req_recv(req, buf, total_len);
+    int received = httpd_req_recv(req, body, total_len);
     if (received <= 0) {
-        free(buf);
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Recv fail");
         return ESP_FAIL;
     }
-    buf[received] = '\0';
-
-    char ssid[33] = {0};
-    char pass[65] = {0};
-    parse_form_value(buf, "ssid", ssid, sizeof(ssid));
-    parse_form_value(buf, "pass", pass, sizeof(pass));
-
-    free(buf);
+    body[received] = '\0';
 
-    if (ssid[0] == '\0') {
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "SSID required");
+    char mode[8] = {0};
+    if (parse_form_value(body, "mode", mode, sizeof(mode)) != ESP_OK ||
+        (strcmp(mode, "panic") != 0 && strcmp(mode, "hang") != 0)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "mode=panic or mode=hang required");
+        return ESP_FAIL;
+    }
+    uint32_t fire_ms = 0;
+    char text[8] = {0};
+    esp_err_t err = parse_form_value(body, "fire_ms", text, sizeof(text));
+    if (err == ESP_OK) {
+        char* end = NULL;
+        fire_ms = (uint32_t)strtoul(text, &end, 10);
+        if (end == text || *end != '\0' || fire_ms < FAULT_MIN_DELAY_MS ||
+            fire_ms >= config->values.max_hold_ms) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                                "fire_ms must be at least 100 and below max_hold_ms");
+            return ESP_FAIL;
+        }
+    } else if (err != ESP_ERR_NOT_FOUND) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "fire_ms too long");
         return ESP_FAIL;
     }
 
-    wifi_store_credentials(ssid, pass);
-    wifi_connect_sta();
+    uint32_t delay_ms = fire_ms > 0 ? fire_ms : FAULT_MIN_DELAY_MS;
+    if (!fault_inject_start(strcmp(mode, "hang") == 0, delay_ms, fire_ms > 0)) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Press not accepted");
+        return ESP_FAIL;
+    }
 
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_sendstr(
-        req, "<html><body><h2>Saved. Reconnecting...</h2><a href=\"/\">Back</a></body></html>");
-    return ESP_OK;
+    char payload[48];
+    snprintf(payload, sizeof(payload), "{\"fault\":\"%s\",\"in_ms\":%" PRIu32 "}", mode,
+             delay_ms);
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_sendstr(req, payload);
 }
+#endif
 
 static void start_mdns(void) {
     mdns_init();
@@ -602,6 +2182,9 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t e
         wifi_connect_sta();
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
         esp_wifi_connect();
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_SCAN_DONE) {
+        const wifi_event_sta_scan_done_t* done = event_data;
+        wifi_scan_finish(done->status == 0);
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         start_mdns();
         if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) == pdTRUE) {
@@ -628,13 +2211,15 @@ static void wifi_init_ap_sta(void) {
     esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL,
                                         NULL);
 
+    const char* ap_ssid = config->values.ap_ssid;
+    const char* ap_pass = config->values.ap_pass;
     wifi_config_t ap_config = {0};
-    strncpy((char*)ap_config.ap.ssid, AP_SSID, sizeof(ap_config.ap.ssid));
-    ap_config.ap.ssid_len = strlen(AP_SSID);
-    strncpy((char*)ap_config.ap.password, AP_PASS, sizeof(ap_config.ap.password));
+    strncpy((char*)ap_config.ap.ssid, ap_ssid, sizeof(ap_config.ap.ssid));
+    ap_config.ap.ssid_len = strlen(ap_ssid);
+    strncpy((char*)ap_config.ap.password, ap_pass, sizeof(ap_config.ap.password));
     ap_config.ap.max_connection = AP_MAX_CONN;
     ap_config.ap.authmode = WIFI_AUTH_WPA_WPA2_PSK;
-    if (strlen(AP_PASS) == 0) {
+    if (strlen(ap_pass) == 0) {
         ap_config.ap.authmode = WIFI_AUTH_OPEN;
     }
 
@@ -645,9 +2230,23 @@ static void wifi_init_ap_sta(void) {
     wifi_connect_sta();
 }
 
+static void ws_session_closed(httpd_handle_t handle, int fd) {
+    (void)handle;
+    ws_clients_remove(fd);
+    close(fd);
+}
+
 static httpd_handle_t start_http_server(void) {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.uri_match_fn = httpd_uri_match_wildcard;
+    config.close_fn = ws_session_closed;
+    config.max_uri_handlers = 12;
+
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        ws_clients[i].fd = -1;
+        ws_clients[i].inflight = 0;
+        ws_clients[i].stale = false;
+    }
 
     httpd_handle_t server = NULL;
     if (httpd_start(&server, &config) != ESP_OK) {
@@ -678,6 +2277,64 @@ static httpd_handle_t start_http_server(void) {
     };
     httpd_register_uri_handler(server, &wifi_post_uri);
 
+    httpd_uri_t wifi_scan_uri = {
+        .uri = "/wifi/scan",
+        .method = HTTP_GET,
+        .handler = wifi_scan_get_handler,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &wifi_scan_uri);
+
+    httpd_uri_t config_get_uri = {
+        .uri = "/config",
+        .method = HTTP_GET,
+        .handler = config_get_handler,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &config_get_uri);
+
+    httpd_uri_t config_post_uri = {
+        .uri = "/config",
+        .method = HTTP_POST,
+        .handler = config_post_handler,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &config_post_uri);
+
+    httpd_uri_t capture_get_uri = {
+        .uri = "/capture",
+        .method = HTTP_GET,
+        .handler = capture_get_handler,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &capture_get_uri);
+
+    httpd_uri_t capture_post_uri = {
+        .uri = "/capture",
+        .method = HTTP_POST,
+        .handler = capture_post_handler,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &capture_post_uri);
+
+    httpd_uri_t link_rtt_reset_uri = {
+        .uri = "/link_rtt/reset",
+        .method = HTTP_POST,
+        .handler = link_rtt_reset_handler,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &link_rtt_reset_uri);
+
+#if CONFIG_POOFER_FAULT_INJECT
+    httpd_uri_t fault_uri = {
+        .uri = "/fault",
+        .method = HTTP_POST,
+        .handler = fault_post_handler,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &fault_uri);
+#endif
+
     httpd_uri_t ws_uri = {
         .uri = WS_URI,
         .method = HTTP_GET,
@@ -700,34 +2357,119 @@ static void mount_spiffs(void) {
     esp_vfs_spiffs_register(&conf);
 }
 
-static void status_task(void* arg) {
+static void IRAM_ATTR trigger_isr(void* arg) {
     (void)arg;
+    BaseType_t woken = pdFALSE;
+    taskENTER_CRITICAL_ISR(&trigger_mux);
+    if (trigger_edge_us == 0) {
+        trigger_edge_us = esp_timer_get_time();
+    }
+    taskEXIT_CRITICAL_ISR(&trigger_mux);
+    vTaskNotifyGiveFromISR(trigger_task_handle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// Blocks until the ISR reports an edge or a debounce deadline falls due, then feeds the press
+// logic directly; there is no periodic polling of the pin.
+static void trigger_task(void* arg) {
+    gpio_num_t pin = (gpio_num_t)(intptr_t)arg;
+    trigger_debounce_t debounce;
+    trigger_debounce_init(&debounce, (uint32_t)config->values.trigger_debounce_ms * 1000U);
+    if (gpio_get_level(pin) == 0) {
+        // Held at boot: require a release before the first fire.
+        ESP_LOGW(TAG, "Trigger held at boot, waiting for release");
+        debounce.pressed = true;
+    }
+
     while (true) {
-        bool should_send = false;
-        bool should_stop = false;
-        if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) == pdTRUE) {
-            int64_t now = esp_timer_get_time();
-            if (runtime.press_active) {
-                int64_t elapsed = now - runtime.press_start_us;
-                if (elapsed >= (int64_t)MAX_HOLD_MS * 1000LL) {
-                    runtime.last_hold_ms = MAX_HOLD_MS;
-                    runtime.press_active = false;
-                    runtime.press_ignore_until_release = true;
-                    runtime.state = STATE_READY;
-                    update_status_led_locked();
-                    should_send = true;
+        TickType_t wait = portMAX_DELAY;
+        int64_t due_us = 0;
+        if (trigger_debounce_deadline(&debounce, &due_us)) {
+            int64_t remaining_us = due_us - esp_timer_get_time();
+            wait = remaining_us > 0 ? pdMS_TO_TICKS((remaining_us + 999) / 1000) : 0;
+            if (remaining_us > 0 && wait == 0) {
+                wait = 1;
+            }
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        taskENTER_CRITICAL(&trigger_mux);
+        int64_t edge_us = trigger_edge_us;
+        trigger_edge_us = 0;
+        taskEXIT_CRITICAL(&trigger_mux);
+
+        int64_t now = esp_timer_get_time();
+        bool active = gpio_get_level(pin) == 0;
+        trigger_event_t event = trigger_debounce_update(&debounce, active, now);
+        if (event == TRIGGER_EVENT_PRESS) {
+            capture_record(CAPTURE_TRIGGER_DOWN, 0, NULL, 0, 0);
+            if (!handle_press_down(PRESS_SOURCE_TRIGGER)) {
+                continue;
+            }
+            if (edge_us == 0 || edge_us > now) {
+                edge_us = now;
+            }
+            uint32_t latency_us = (uint32_t)(esp_timer_get_time() - edge_us);
+            if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) == pdTRUE) {
+                runtime.trigger_latency_us = latency_us;
+                if (latency_us > runtime.trigger_latency_max_us) {
+                    runtime.trigger_latency_max_us = latency_us;
                 }
+                xSemaphoreGive(state_lock);
             }
+            ESP_LOGI(TAG, "Trigger edge to solenoid: %" PRIu32 " us", latency_us);
+        } else if (event == TRIGGER_EVENT_RELEASE) {
+            capture_record(CAPTURE_TRIGGER_UP, 0, NULL, 0, 0);
+            handle_press_up(PRESS_SOURCE_TRIGGER);
+        }
+    }
+}
 
-            if (runtime.press_active && runtime.last_ws_rx_us != 0) {
-                if ((now - runtime.last_ws_rx_us) > 2000000) {
-                    stop_firing_locked(STATE_DISCONNECTED);
-                    runtime.ws_connected = false;
-                    should_stop = true;
-                }
+static void init_trigger(void) {
+    int pin = config->values.trigger_gpio;
+    if (pin < 0) {
+        return;
+    }
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << pin,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_ANYEDGE,
+    };
+    if (gpio_config(&io_conf) != ESP_OK) {
+        ESP_LOGE(TAG, "Trigger GPIO%d config failed", pin);
+        return;
+    }
+    if (xTaskCreate(trigger_task, "trigger_task", 3072, (void*)(intptr_t)pin, 10,
+                    &trigger_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Trigger task create failed");
+        return;
+    }
+    gpio_install_isr_service(0);
+    gpio_isr_handler_add((gpio_num_t)pin, trigger_isr, NULL);
+    ESP_LOGI(TAG, "Trigger on GPIO%d, %u ms debounce", pin,
+             (unsigned)config->values.trigger_debounce_ms);
+}
+
+static void status_task(void* arg) {
+    (void)arg;
+    while (true) {
+        bool should_send = false;
+        bool firing = false;
+        bool controller = false;
+        uint32_t probe_seq = 0;
+        bool locked = xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) == pdTRUE;
+        if (locked) {
+            int64_t now = esp_timer_get_time();
+            int64_t link_timeout_us = (int64_t)config->values.link_timeout_ms * 1000LL;
+            // Backstops for a missed max-hold timer and a WS controller that went silent.
+            if (fire_control_poll(&runtime.fire, runtime.last_ws_rx_us)) {
+                should_send = true;
             }
             if (runtime.ws_connected && runtime.last_ws_rx_us != 0 &&
-                (now - runtime.last_ws_rx_us) > 2000000) {
+                (now - runtime.last_ws_rx_us) > link_timeout_us) {
                 runtime.ws_connected = false;
                 if (runtime.state != STATE_ERROR && runtime.state != STATE_FIRING) {
                     runtime.state = STATE_DISCONNECTED;
@@ -735,13 +2477,34 @@ static void status_task(void* arg) {
                 }
                 should_send = true;
             }
+            firing = runtime.fire.active;
+            controller = runtime.ws_connected;
+            if (controller &&
+                now - runtime.link_probe_sent_us >= LINK_PROBE_PERIOD_MS * 1000LL) {
+                if (runtime.link_probe_pending) {
+                    runtime.link_probes_lost++;
+                }
+                probe_seq = ++runtime.link_probe_seq;
+                runtime.link_probe_sent_us = now;
+                runtime.link_probe_pending = true;
+            }
+            crash_record_update_locked();
             xSemaphoreGive(state_lock);
         }
 
-        if (should_send || should_stop) {
-            send_state_async();
+        if (should_send) {
+            request_state_push();
         }
-        vTaskDelay(pdMS_TO_TICKS(200));
+        if (probe_seq != 0) {
+            char probe[32];
+            int len = snprintf(probe, sizeof(probe), "{\"probe\":%" PRIu32 "}", probe_seq);
+            ws_broadcast(probe, (size_t)len, WS_SEND_PROBE);
+        }
+        // Without the lock the firing state is unknown, and a scan must not start mid-burn.
+        if (locked) {
+            wifi_scan_poll(firing, controller);
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(200));
     }
 }
 
@@ -760,11 +2523,42 @@ static void init_led_strip(void) {
         .flags.with_dma = false,
     };
     led_strip_new_rmt_device(&strip_config, &rmt_config, &strip);
-    update_status_led_locked();
-    set_solenoid_level_locked(0);
+    // The pixels latch their last frame across a CPU reset, so a crash mid-burn leaves the
+    // solenoids open until a new frame is clocked out.
+    if (strip) {
+        led_strip_clear(strip);
+    }
+}
+
+static void init_config(void) {
+    poofer_config_t values;
+    config_load(&values);
+    config_slot_build(&config_slots[0], &values);
+    config = &config_slots[0];
+
+    const config_slot_t* slot = config;
+    const solenoid_profile_t* profiles = slot->values.solenoid_profiles;
+    uint32_t full_mj = 0;
+    for (size_t ch = 0; ch < SOLENOID_CHANNELS; ch++) {
+        full_mj += (uint32_t)((uint64_t)SOLENOID_SUPPLY_MV * profiles[ch].coil_ma *
+                              slot->values.max_hold_ms / 1000000ULL);
+    }
+    ESP_LOGI(TAG, "Solenoid profile: %u frames, %" PRIu32 " mJ min / %" PRIu32
+                  " mJ max per fire (full drive %" PRIu32 " mJ)",
+             (unsigned)slot->solenoid_frame_count,
+             solenoid_energy_mj(slot->solenoid_frames, slot->solenoid_frame_count, profiles,
+                                slot->values.min_hold_ms),
+             solenoid_energy_mj(slot->solenoid_frames, slot->solenoid_frame_count, profiles,
+                                slot->values.max_hold_ms),
+             full_mj);
 }
 
 void app_main(void) {
+    // Nothing else runs until the solenoid pixels have been driven off.
+    init_led_strip();
+    boot_report.safe_us = esp_timer_get_time();
+    boot_report_init();
+
     nvs_flash_init();
 
     state_lock = xSemaphoreCreateMutex();
@@ -772,7 +2566,10 @@ void app_main(void) {
         return;
     }
 
-    init_led_strip();
+    init_config();
+    fire_config_t fire_config = fire_config_from_slot(config);
+    fire_control_init(&runtime.fire, &fire_hooks, &fire_config);
+    update_status_led_locked();
 
     const esp_timer_create_args_t timer_args = {
         .callback = &max_hold_timer_cb,
@@ -792,7 +2589,15 @@ void app_main(void) {
     };
     esp_timer_create(&kick_args, &solenoid_kick_timer);
 
-    mount_spiffs();
+#if CONFIG_POOFER_FAULT_INJECT
+    const esp_timer_create_args_t fault_args = {
+        .callback = &fault_timer_cb,
+        .name = "fault",
+    };
+    esp_timer_create(&fault_args, &fault_timer);
+    ESP_LOGW(TAG, "Fault injection enabled: POST /fault crashes this device");
+#endif
+
     wifi_init_ap_sta();
 
     if (xSemaphoreTake(state_lock, pdMS_TO_TICKS(50)) == pdTRUE) {
@@ -803,5 +2608,23 @@ void app_main(void) {
 
     httpd = start_http_server();
 
-    xTaskCreate(status_task, "status_task", 4096, NULL, 5, NULL);
+    xTaskCreate(status_task, "status_task", 4096, NULL, 5, &status_task_handle);
+    xTaskCreate(push_task, "push_task", 4096, NULL, 6, NULL);
+
+    init_trigger();
+
+    boot_report.control_ready_us = esp_timer_get_time();
+    ESP_LOGI(TAG, "Control ready %lld us after start", (long long)boot_report.control_ready_us);
+
+    // UI assets are only needed once a browser loads a page, so they come after the control path.
+    mount_spiffs();
+
+#if CONFIG_POOFER_FAULT_INJECT && CONFIG_POOFER_FAULT_BOOT_FIRE_MS > 0
+    // QEMU has no Wi-Fi to reach POST /fault through, so this build crashes itself on every boot.
+    if (CONFIG_POOFER_FAULT_BOOT_FIRE_MS < config->values.max_hold_ms) {
+        fault_inject_start(false, CONFIG_POOFER_FAULT_BOOT_FIRE_MS, true);
+    } else {
+        ESP_LOGE(TAG, "POOFER_FAULT_BOOT_FIRE_MS must be below max_hold_ms");
+    }
+#endif
 }
@@ -0,0 +1,54 @@
+#include "trigger_debounce.h"
+
+void trigger_debounce_init(trigger_debounce_t* debounce, uint32_t debounce_us) {
+    debounce->debounce_us = debounce_us;
+    debounce->pressed = false;
+    debounce->pending = false;
+    debounce->due_us = 0;
+    debounce->last_release_us = -(int64_t)debounce_us;
+}
+
+trigger_event_t trigger_debounce_update(trigger_debounce_t* debounce, bool active, int64_t now_us) {
+    bool expired = debounce->pending && now_us >= debounce->due_us;
+
+    if (active) {
+        if (debounce->pressed) {
+            // Contact bounce during a release: the release has to start over.
+            debounce->pending = false;
+            return TRIGGER_EVENT_NONE;
+        }
+        if (now_us - debounce->last_release_us >= debounce->debounce_us) {
+            debounce->pressed = true;
+            debounce->pending = false;
+            return TRIGGER_EVENT_PRESS;
+        }
+        debounce->pending = true;
+        debounce->due_us = debounce->last_release_us + debounce->debounce_us;
+        return TRIGGER_EVENT_NONE;
+    }
+
+    if (!debounce->pressed) {
+        debounce->pending = false;
+        return TRIGGER_EVENT_NONE;
+    }
+    if (!debounce->pending) {
+        debounce->pending = true;
+        debounce->due_us = now_us + debounce->debounce_us;
+        return TRIGGER_EVENT_NONE;
+    }
+    if (!expired) {
+        return TRIGGER_EVENT_NONE;
+    }
+    debounce->pressed = false;
+    debounce->pending = false;
+    debounce->last_release_us = now_us;
+    return TRIGGER_EVENT_RELEASE;
+}
+
+bool trigger_debounce_deadline(const trigger_debounce_t* debounce, int64_t* due_us) {
+    if (!debounce->pending) {
+        return false;
+    }
+    *due_us = debounce->due_us;
+    return true;
+}
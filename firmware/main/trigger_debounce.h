@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Debounce for a dead-man trigger input. Presses are taken on the leading edge so the fire path
+// adds no delay; releases must hold for debounce_us before they count, and a press that lands
+// inside the lockout after a release is re-checked once the lockout ends.
+//
+// No ESP-IDF dependencies: the caller feeds it the sampled level and a timestamp after every
+// edge and at every deadline, so it can be driven by synthetic edge traces on a host.
+
+typedef enum {
+    TRIGGER_EVENT_NONE = 0,
+    TRIGGER_EVENT_PRESS,
+    TRIGGER_EVENT_RELEASE,
+} trigger_event_t;
+
+typedef struct {
+    int64_t debounce_us;
+    bool pressed;
+    bool pending;
+    int64_t due_us;
+    int64_t last_release_us;
+} trigger_debounce_t;
+
+void trigger_debounce_init(trigger_debounce_t* debounce, uint32_t debounce_us);
+
+trigger_event_t trigger_debounce_update(trigger_debounce_t* debounce, bool active, int64_t now_us);
+
+// Returns true and the time the level must be sampled again if a press or release is pending.
+bool trigger_debounce_deadline(const trigger_debounce_t* debounce, int64_t* due_us);
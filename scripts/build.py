@@ -1,4 +1,5 @@
 #!/usr/bin/env python3
+import argparse
 import os
 import subprocess
 from pathlib import Path
@@ -6,5 +7,33 @@ from pathlib import Path
 ROOT = Path(__file__).resolve().parents[1]
 FIRMWARE = ROOT / "firmware"
 
+parser = argparse.ArgumentParser(description="Build firmware")
+variant = parser.add_mutually_exclusive_group()
+variant.add_argument(
+    "--fault-inject",
+    action="store_true",
+    help="Debug build with POST /fault into build-fault/ (see README, Crash Recovery)",
+)
+variant.add_argument(
+    "--qemu-fault",
+    action="store_true",
+    help="Debug build that fires and panics on every boot, into build-qemu/ for idf.py qemu",
+)
+args = parser.parse_args()
+
 idf_py = os.environ.get("POOFER_IDF_PY", "idf.py")
-subprocess.run([idf_py, "build"], cwd=FIRMWARE, check=True)
+cmd = [idf_py]
+if args.fault_inject or args.qemu_fault:
+    build_dir = "build-qemu" if args.qemu_fault else "build-fault"
+    overlay = "sdkconfig.qemu_fault" if args.qemu_fault else "sdkconfig.fault_inject"
+    cmd += [
+        "-B",
+        build_dir,
+        "-D",
+        f"SDKCONFIG={build_dir}/sdkconfig",
+        "-D",
+        f"SDKCONFIG_DEFAULTS=sdkconfig.defaults;{overlay}",
+    ]
+cmd += ["build"]
+
+subprocess.run(cmd, cwd=FIRMWARE, check=True)
@@ -22,7 +22,7 @@ fi
 declare -a c_files=()
 while IFS= read -r -d '' file; do
   c_files+=("$file")
-done < <(git ls-files -z "firmware/**/*.c" "firmware/**/*.h")
+done < <(git ls-files -z "firmware/**/*.c" "firmware/**/*.h" "tests/*.c")
 if [ "${#c_files[@]}" -gt 0 ]; then
   clang-format --dry-run --Werror "${c_files[@]}"
 fi
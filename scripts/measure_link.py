@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""Measure the control-link round trip with and without a Wi-Fi scan running.
+
+While a WebSocket controller is connected, the device sends it a {"probe":N} frame once a second
+and times the "ACK N" reply. Round trips that overlap a scan are kept apart from idle ones. This
+script resets those stats, connects as the controller, answers every probe, and asks for a scan
+every --scan-every seconds. It then prints the stats that GET /config reports.
+
+Stay connected to the device AP for the whole run and keep other controllers closed, since the
+first ACK to a probe is the one that counts.
+"""
+
+import argparse
+import base64
+import json
+import os
+import socket
+import struct
+import sys
+import time
+import urllib.request
+
+OP_TEXT = 0x1
+OP_CLOSE = 0x8
+OP_PING = 0x9
+OP_PONG = 0xA
+
+
+def _fail(msg: str) -> None:
+    print(f"ERROR: {msg}", file=sys.stderr)
+    sys.exit(1)
+
+
+def http(base: str, path: str, data: bytes | None = None) -> dict:
+    with urllib.request.urlopen(f"{base}{path}", data=data, timeout=5) as resp:
+        return json.load(resp)
+
+
+class WebSocket:
+    """Just enough of RFC 6455 for short text frames to and from the device."""
+
+    def __init__(self, host: str, path: str) -> None:
+        self.sock = socket.create_connection((host, 80), timeout=5)
+        key = base64.b64encode(os.urandom(16)).decode()
+        self.sock.sendall(
+            (
+                f"GET {path} HTTP/1.1\r\nHost: {host}\r\nUpgrade: websocket\r\n"
+                f"Connection: Upgrade\r\nSec-WebSocket-Key: {key}\r\n"
+                "Sec-WebSocket-Version: 13\r\n\r\n"
+            ).encode()
+        )
+        response = b""
+        while b"\r\n\r\n" not in response:
+            chunk = self.sock.recv(1024)
+            if not chunk:
+                _fail("WebSocket handshake closed")
+            response += chunk
+        if not response.startswith(b"HTTP/1.1 101"):
+            _fail(f"WebSocket handshake failed: {response.splitlines()[0].decode()}")
+        self.buffer = response.split(b"\r\n\r\n", 1)[1]
+
+    def send(self, opcode: int, payload: bytes) -> None:
+        mask = os.urandom(4)
+        header = bytes([0x80 | opcode])
+        if len(payload) < 126:
+            header += bytes([0x80 | len(payload)])
+        else:
+            header += bytes([0x80 | 126]) + struct.pack(">H", len(payload))
+        masked = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+        self.sock.sendall(header + mask + masked)
+
+    def send_text(self, text: str) -> None:
+        self.send(OP_TEXT, text.encode())
+
+    def _fill(self, n: int) -> None:
+        # Data read before a timeout stays buffered, so a frame split across reads is not lost.
+        while len(self.buffer) < n:
+            chunk = self.sock.recv(4096)
+            if not chunk:
+                _fail("WebSocket closed by the device")
+            self.buffer += chunk
+
+    def recv(self) -> tuple[int, bytes]:
+        self._fill(2)
+        length = self.buffer[1] & 0x7F
+        offset = 2
+        if length == 126:
+            self._fill(4)
+            (length,) = struct.unpack_from(">H", self.buffer, 2)
+            offset = 4
+        elif length == 127:
+            self._fill(10)
+            (length,) = struct.unpack_from(">Q", self.buffer, 2)
+            offset = 10
+        self._fill(offset + length)
+        opcode = self.buffer[0] & 0x0F
+        payload = self.buffer[offset : offset + length]
+        self.buffer = self.buffer[offset + length :]
+        return opcode, payload
+
+
+def print_stats(name: str, stats: dict) -> None:
+    count = stats.get(f"{name}_count", 0)
+    if not count:
+        print(f"{name}: no samples")
+        return
+    print(
+        f"{name}: {count} samples, min {stats[f'{name}_min_us'] / 1000:.1f} ms, "
+        f"mean {stats[f'{name}_mean_us'] / 1000:.1f} ms, "
+        f"max {stats[f'{name}_max_us'] / 1000:.1f} ms"
+    )
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Measure control-link round trips")
+    parser.add_argument("--host", default="192.168.4.1", help="Device address")
+    parser.add_argument("--duration", type=float, default=120.0, help="Seconds to measure")
+    parser.add_argument(
+        "--scan-every",
+        type=float,
+        default=15.0,
+        help="Seconds between scan requests (0 = idle only)",
+    )
+    args = parser.parse_args()
+
+    base = f"http://{args.host}"
+    try:
+        http(base, "/link_rtt/reset", data=b"")
+    except OSError as err:
+        _fail(f"POST /link_rtt/reset failed: {err}")
+
+    ws = WebSocket(args.host, "/ws")
+    ws.sock.settimeout(0.2)
+    start = time.monotonic()
+    next_ping = start
+    next_scan = start + 2.0 if args.scan_every > 0 else float("inf")
+    probes = 0
+    while time.monotonic() - start < args.duration:
+        now = time.monotonic()
+        if now >= next_ping:
+            # Keeps the device from timing out the link, like the control page does.
+            ws.send_text("PING")
+            next_ping += 1.0
+        if now >= next_scan:
+            try:
+                http(base, "/wifi/scan?refresh=1")
+            except OSError as err:
+                print(f"WARNING: scan request failed: {err}", file=sys.stderr)
+            next_scan += args.scan_every
+        try:
+            opcode, payload = ws.recv()
+        except TimeoutError:
+            continue
+        if opcode == OP_CLOSE:
+            _fail("WebSocket closed by the device")
+        if opcode == OP_PING:
+            ws.send(OP_PONG, payload)
+        elif opcode == OP_TEXT:
+            data = json.loads(payload)
+            if "probe" in data:
+                ws.send_text(f"ACK {data['probe']}")
+                probes += 1
+    ws.send(OP_CLOSE, b"")
+
+    stats = http(base, "/config")
+    print(f"answered {probes} probes, {stats.get('link_probes_lost', 0)} lost")
+    print(f"scans: {stats.get('wifi_scans', 0)} ({stats.get('wifi_scan_failures', 0)} failed)")
+    print_stats("link_rtt_idle", stats)
+    print_stats("link_rtt_scan", stats)
+
+
+if __name__ == "__main__":
+    main()
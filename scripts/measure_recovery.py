@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+"""Crash the device through POST /fault and report how long it takes to recover.
+
+Needs a firmware built with CONFIG_POOFER_FAULT_INJECT (`scripts/build.py --fault-inject`). For
+each run the device is crashed, optionally in the middle of a fire, and `GET /config` is polled
+until it answers from the next boot. The device reports boot_safe_us and boot_control_ready_us,
+counted from app start. The host time runs from the crash to the first answer, so it also covers
+the bootloader and the client rejoining the AP.
+
+With --qemu no device is needed: the `scripts/build.py --qemu-fault` build fires and panics on
+every boot, and the same two times are read from its log under `idf.py qemu`.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import threading
+import time
+import urllib.error
+import urllib.parse
+import urllib.request
+from pathlib import Path
+
+FIRMWARE = Path(__file__).resolve().parents[1] / "firmware"
+
+FAULT_RESETS = {"panic", "int_wdt", "task_wdt", "wdt"}
+
+RECOVERED_RE = re.compile(r"Recovered from (\w+), boot (\d+), was firing: (yes|no) \((\d+) ms\)")
+SAFE_RE = re.compile(r"Outputs safe (\d+) us after start")
+READY_RE = re.compile(r"Control ready (\d+) us after start")
+
+
+def _fail(msg: str) -> None:
+    print(f"ERROR: {msg}", file=sys.stderr)
+    sys.exit(1)
+
+
+def get_config(base: str, timeout: float) -> dict:
+    with urllib.request.urlopen(f"{base}/config", timeout=timeout) as resp:
+        return json.load(resp)
+
+
+def post_fault(base: str, mode: str, fire_ms: int) -> int:
+    fields = {"mode": mode}
+    if fire_ms:
+        fields["fire_ms"] = str(fire_ms)
+    data = urllib.parse.urlencode(fields).encode()
+    try:
+        with urllib.request.urlopen(f"{base}/fault", data=data, timeout=5) as resp:
+            return int(json.load(resp)["in_ms"])
+    except urllib.error.HTTPError as err:
+        if err.code == 404:
+            _fail("POST /fault not found; flash a build made with scripts/build.py --fault-inject")
+        _fail(f"POST /fault failed: {err.code} {err.read().decode(errors='replace')}")
+    return 0
+
+
+def run_once(base: str, mode: str, fire_ms: int, timeout_s: float) -> dict:
+    before = get_config(base, 5)
+    in_ms = post_fault(base, mode, fire_ms)
+    crash_at = time.monotonic() + in_ms / 1000.0
+    time.sleep(in_ms / 1000.0)
+
+    deadline = crash_at + timeout_s
+    while time.monotonic() < deadline:
+        try:
+            after = get_config(base, 1)
+        except (OSError, ValueError):
+            time.sleep(0.1)
+            continue
+        if after.get("boot_count") != before.get("boot_count"):
+            after["host_recovery_s"] = time.monotonic() - crash_at
+            return after
+        time.sleep(0.1)
+    _fail(f"No new boot within {timeout_s:.0f}s")
+    return {}
+
+
+def run_qemu(runs: int, timeout_s: float) -> list[dict]:
+    """Reads boots from the crash-looping QEMU build's log until `runs` recoveries are seen.
+
+    The first boot is a power-on, not a recovery, so it is skipped.
+    """
+    idf_py = os.environ.get("POOFER_IDF_PY", "idf.py")
+    proc = subprocess.Popen(
+        [idf_py, "-B", "build-qemu", "qemu"],
+        cwd=FIRMWARE,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.STDOUT,
+        text=True,
+        errors="replace",
+    )
+    assert proc.stdout is not None
+    timer = threading.Timer(timeout_s * (runs + 1), proc.kill)
+    timer.start()
+    results: list[dict] = []
+    recovered = None
+    boot = None
+    try:
+        for line in proc.stdout:
+            if match := RECOVERED_RE.search(line):
+                recovered = match
+            elif match := SAFE_RE.search(line):
+                boot = {"boot_safe_us": int(match.group(1)), "reset_reason": "poweron"}
+                if recovered:
+                    boot["reset_reason"] = recovered.group(1)
+                    boot["boot_count"] = int(recovered.group(2))
+                    boot["reset_was_firing"] = recovered.group(3) == "yes"
+                    boot["reset_fire_ms"] = int(recovered.group(4))
+                recovered = None
+            elif (match := READY_RE.search(line)) and boot:
+                boot["boot_control_ready_us"] = int(match.group(1))
+                if "boot_count" in boot:
+                    results.append(boot)
+                boot = None
+                if len(results) == runs:
+                    break
+    finally:
+        timer.cancel()
+        proc.kill()
+        proc.wait()
+    if len(results) < runs:
+        _fail(
+            f"Only {len(results)} of {runs} recovered boots seen under QEMU; check that "
+            "scripts/build.py --qemu-fault was built and that the log reaches Control ready"
+        )
+    return results
+
+
+def summarize(name: str, values: list[float], unit: str) -> None:
+    mean = sum(values) / len(values)
+    print(f"{name}: min {min(values):.1f}, mean {mean:.1f}, max {max(values):.1f} {unit}")
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Measure crash recovery through POST /fault")
+    parser.add_argument("--host", default="192.168.4.1", help="Device address")
+    parser.add_argument("--mode", choices=["panic", "hang"], default="panic")
+    parser.add_argument(
+        "--fire-ms",
+        type=int,
+        default=0,
+        help="Start a fire and crash this many ms into it (0 = crash while idle)",
+    )
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("--timeout", type=float, default=60.0, help="Seconds to wait per run")
+    parser.add_argument(
+        "--qemu",
+        action="store_true",
+        help="Read boot times from the scripts/build.py --qemu-fault build under idf.py qemu",
+    )
+    args = parser.parse_args()
+
+    base = f"http://{args.host}"
+    # The QEMU build always crashes mid-fire (CONFIG_POOFER_FAULT_BOOT_FIRE_MS).
+    expect_firing = args.qemu or args.fire_ms > 0
+    results = run_qemu(args.runs, args.timeout) if args.qemu else []
+    safe_us, ready_us, host_s = [], [], []
+    ok = True
+    for run in range(args.runs):
+        if args.qemu:
+            result = results[run]
+        else:
+            result = run_once(base, args.mode, args.fire_ms, args.timeout)
+        reason = result.get("reset_reason")
+        was_firing = result.get("reset_was_firing")
+        host = f" host={result['host_recovery_s']:.2f}s" if "host_recovery_s" in result else ""
+        print(
+            f"run {run + 1}: reset_reason={reason} reset_was_firing={was_firing} "
+            f"reset_fire_ms={result.get('reset_fire_ms')} "
+            f"boot_safe_us={result.get('boot_safe_us')} "
+            f"boot_control_ready_us={result.get('boot_control_ready_us')}{host}"
+        )
+        if reason not in FAULT_RESETS or bool(was_firing) != expect_firing:
+            ok = False
+        safe_us.append(float(result.get("boot_safe_us", 0)))
+        ready_us.append(float(result.get("boot_control_ready_us", 0)))
+        if "host_recovery_s" in result:
+            host_s.append(result["host_recovery_s"])
+
+    summarize("boot_safe_us", safe_us, "us")
+    summarize("boot_control_ready_us", ready_us, "us")
+    if host_s:
+        summarize("host recovery", host_s, "s")
+    if not ok:
+        _fail("A reset was not reported as a fault, or the fire was not recorded")
+
+
+if __name__ == "__main__":
+    main()
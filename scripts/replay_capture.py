@@ -0,0 +1,306 @@
+#!/usr/bin/env python3
+"""Replay a WebSocket session capture against the firmware's firing state machine.
+
+The capture is downloaded from the device with `GET /capture`. Every inbound frame and local
+trigger edge is fed at its recorded time to tests/replay_runner.c, a host build of
+firmware/main/fire_control.c, and its solenoid and firing timelines are diffed against what the
+device recorded.
+"""
+
+import argparse
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+from dataclasses import dataclass, field
+from pathlib import Path
+
+REPO_ROOT = Path(__file__).resolve().parent.parent
+
+MAGIC = b"PFCP"
+VERSIONS = {1, 2, 3}
+HEADER = struct.Struct("<4sHHIIIIII")
+FRAME = struct.Struct("<I2B2x")
+RECORD = struct.Struct("<IBB2BII")
+
+WS_OPEN = 1
+RX_DOWN = 2
+RX_UP = 3
+RX_PING = 4
+RX_OTHER = 5
+TX_STATE = 6
+SOLENOID = 7
+TRIGGER_DOWN = 8
+TRIGGER_UP = 9
+SCAN_START = 10
+SCAN_DONE = 11
+
+FLAG_FIRING = 1 << 1
+
+STATUS_PERIOD_MS = 200.0
+
+INPUT_KINDS = {WS_OPEN, RX_DOWN, RX_UP, RX_PING, RX_OTHER, TRIGGER_DOWN, TRIGGER_UP}
+RUNNER_EVENTS = {RX_DOWN: "down", RX_UP: "up", TRIGGER_DOWN: "tdown", TRIGGER_UP: "tup"}
+KIND_NAMES = {
+    WS_OPEN: "OPEN",
+    RX_DOWN: "DOWN",
+    RX_UP: "UP",
+    RX_PING: "PING",
+    RX_OTHER: "OTHER",
+    TX_STATE: "STATE",
+    SOLENOID: "SOLENOID",
+    TRIGGER_DOWN: "TRIGGER_DOWN",
+    TRIGGER_UP: "TRIGGER_UP",
+    SCAN_START: "SCAN_START",
+    SCAN_DONE: "SCAN_DONE",
+}
+
+
+def _fail(msg: str) -> None:
+    print(f"ERROR: {msg}", file=sys.stderr)
+    sys.exit(1)
+
+
+@dataclass
+class Record:
+    t_us: int
+    kind: int
+    flags: int
+    levels: tuple[int, int]
+    a: int
+    b: int
+
+
+@dataclass
+class Capture:
+    min_hold_ms: int
+    max_hold_ms: int
+    link_timeout_ms: int
+    dropped: int
+    frames: list[tuple[int, tuple[int, int]]]
+    records: list[Record]
+
+
+def load_capture(path: Path) -> Capture:
+    data = path.read_bytes()
+    if len(data) < HEADER.size:
+        _fail(f"{path} is too short to be a capture")
+    (
+        magic,
+        version,
+        record_size,
+        count,
+        dropped,
+        min_hold_ms,
+        max_hold_ms,
+        link_timeout_ms,
+        frame_count,
+    ) = HEADER.unpack_from(data, 0)
+    if magic != MAGIC or version not in VERSIONS or record_size != RECORD.size:
+        _fail(f"{path} is not a supported poofer capture")
+
+    offset = HEADER.size
+    frames = []
+    for _ in range(frame_count):
+        at_ms, l0, l1 = FRAME.unpack_from(data, offset)
+        frames.append((at_ms, (l0, l1)))
+        offset += FRAME.size
+
+    records = []
+    wraps = 0
+    last_raw = 0
+    for _ in range(count):
+        if offset + RECORD.size > len(data):
+            _fail(f"{path} is truncated")
+        raw_t, kind, flags, l0, l1, a, b = RECORD.unpack_from(data, offset)
+        offset += RECORD.size
+        if raw_t + (1 << 31) < last_raw:
+            wraps += 1
+        last_raw = raw_t
+        records.append(Record(raw_t + (wraps << 32), kind, flags, (l0, l1), a, b))
+
+    return Capture(min_hold_ms, max_hold_ms, link_timeout_ms, dropped, frames, records)
+
+
+def build_runner() -> Path:
+    """Builds the host replay runner around firmware/main/fire_control.c."""
+    build_dir = REPO_ROOT / "build" / "host"
+    for cmd in (
+        ["cmake", "-S", str(REPO_ROOT / "tests"), "-B", str(build_dir)],
+        ["cmake", "--build", str(build_dir), "--target", "replay_runner"],
+    ):
+        result = subprocess.run(cmd, capture_output=True, text=True)
+        if result.returncode != 0:
+            print(result.stdout + result.stderr, file=sys.stderr)
+            _fail(f"Failed to build the replay runner: {' '.join(cmd)}")
+    return build_dir / "replay_runner"
+
+
+@dataclass
+class Replay:
+    solenoid: list[tuple[int, tuple[int, int]]] = field(default_factory=list)
+    state: list[tuple[int, bool]] = field(default_factory=list)
+    # Extra tolerance per timeline entry, for edges the device only checks periodically.
+    solenoid_slack: dict[int, float] = field(default_factory=dict)
+    state_slack: dict[int, float] = field(default_factory=dict)
+
+
+def run_replay(runner: Path, capture: Capture, speed: float, verbose: bool) -> Replay:
+    """Feeds the recorded inputs to the runner and parses the timelines it prints."""
+    with tempfile.TemporaryFile(mode="w+") as output:
+        proc = subprocess.Popen(
+            [str(runner)], stdin=subprocess.PIPE, stdout=output, text=True, bufsize=1
+        )
+        assert proc.stdin is not None
+        proc.stdin.write(
+            f"config {capture.min_hold_ms} {capture.max_hold_ms} {capture.link_timeout_ms}\n"
+        )
+        for at_ms, (l0, l1) in capture.frames:
+            proc.stdin.write(f"frame {at_ms} {l0} {l1}\n")
+
+        wall_start = time.monotonic()
+        for rec in capture.records:
+            if rec.kind not in INPUT_KINDS:
+                # Scans are not inputs, but they explain link gaps in the verbose trace.
+                if verbose and rec.kind == SCAN_START:
+                    print(f"{rec.t_us / 1000:10.1f} ms  SCAN_START")
+                elif verbose and rec.kind == SCAN_DONE:
+                    print(f"{rec.t_us / 1000:10.1f} ms  SCAN_DONE ({rec.a} APs, {rec.b} ms)")
+                continue
+            if speed > 0:
+                delay = rec.t_us / 1e6 / speed - (time.monotonic() - wall_start)
+                if delay > 0:
+                    time.sleep(delay)
+            if verbose:
+                print(f"{rec.t_us / 1000:10.1f} ms  {KIND_NAMES.get(rec.kind, rec.kind)}")
+            proc.stdin.write(f"{rec.t_us} {RUNNER_EVENTS.get(rec.kind, 'ws')}\n")
+        if capture.records:
+            proc.stdin.write(f"end {capture.records[-1].t_us}\n")
+        proc.stdin.close()
+        if proc.wait() != 0:
+            _fail(f"{runner} exited with {proc.returncode}")
+        output.seek(0)
+        lines = output.read().splitlines()
+
+    replay = Replay()
+    for line in lines:
+        fields = line.split()
+        t_us = int(fields[1])
+        if fields[0] == "sol":
+            levels = (int(fields[2]), int(fields[3]))
+            if not replay.solenoid or replay.solenoid[-1][1] != levels:
+                replay.solenoid.append((t_us, levels))
+        elif fields[0] == "fire":
+            if fields[2] == "0" and fields[3] == "link":
+                # The status task checks the link on a fixed period, not at the deadline.
+                if replay.solenoid and replay.solenoid[-1][0] == t_us:
+                    replay.solenoid_slack[len(replay.solenoid) - 1] = STATUS_PERIOD_MS
+                replay.state_slack[len(replay.state)] = STATUS_PERIOD_MS
+            replay.state.append((t_us, fields[2] == "1"))
+    return replay
+
+
+def recorded_timelines(capture: Capture):
+    solenoid: list[tuple[int, tuple[int, int]]] = []
+    state: list[tuple[int, bool]] = []
+    firing = False
+    for rec in capture.records:
+        if rec.kind == SOLENOID and (not solenoid or solenoid[-1][1] != rec.levels):
+            solenoid.append((rec.t_us, rec.levels))
+        elif rec.kind == TX_STATE:
+            now_firing = bool(rec.flags & FLAG_FIRING)
+            if now_firing != firing:
+                state.append((rec.t_us, now_firing))
+            firing = now_firing
+    return solenoid, state
+
+
+def diff_timelines(
+    name: str, recorded: list, replayed: list, slack: dict[int, float], tolerance_ms: float
+) -> bool:
+    deltas = []
+    mismatches = 0
+    late = 0
+    for i in range(max(len(recorded), len(replayed))):
+        if i >= len(recorded) or i >= len(replayed):
+            mismatches += 1
+            continue
+        (rec_t, rec_v), (rep_t, rep_v) = recorded[i], replayed[i]
+        if rec_v != rep_v:
+            mismatches += 1
+            print(
+                f"  {name}[{i}] value differs: recorded {rec_v} @ {rec_t / 1000:.1f} ms, "
+                f"replayed {rep_v} @ {rep_t / 1000:.1f} ms"
+            )
+            continue
+        delta_ms = (rec_t - rep_t) / 1000.0
+        deltas.append(delta_ms)
+        if abs(delta_ms) > tolerance_ms + slack.get(i, 0.0):
+            late += 1
+
+    summary = f"{name}: {len(recorded)} recorded, {len(replayed)} replayed, {mismatches} mismatched"
+    summary += f", {late} outside tolerance"
+    if deltas:
+        abs_deltas = sorted(abs(d) for d in deltas)
+        p95 = abs_deltas[min(len(abs_deltas) - 1, int(len(abs_deltas) * 0.95))]
+        mean = sum(deltas) / len(deltas)
+        summary += f", delta mean {mean:+.2f} ms, p95 {p95:.2f} ms, max {abs_deltas[-1]:.2f} ms"
+    print(summary)
+    return mismatches == 0 and late == 0
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Replay a poofer session capture")
+    parser.add_argument("capture", type=Path, help="Capture file from GET /capture")
+    parser.add_argument(
+        "--speed",
+        type=float,
+        default=0.0,
+        help="Pace inputs in wall-clock time at this multiple of real time (0 = unpaced)",
+    )
+    parser.add_argument(
+        "--tolerance-ms",
+        type=float,
+        default=5.0,
+        help="Largest solenoid timing delta accepted before failing",
+    )
+    parser.add_argument(
+        "--state-tolerance-ms",
+        type=float,
+        default=50.0,
+        help="Largest firing-state delta accepted; state frames lag by up to one push tick",
+    )
+    parser.add_argument("--verbose", action="store_true", help="Print every replayed input")
+    parser.add_argument(
+        "--runner",
+        type=Path,
+        help="Prebuilt tests/replay_runner binary (default: build it under build/host)",
+    )
+    args = parser.parse_args()
+
+    if not args.capture.exists():
+        _fail(f"Missing {args.capture}")
+    capture = load_capture(args.capture)
+    if not capture.frames:
+        _fail("Capture has no solenoid frames")
+    if capture.dropped:
+        print(f"WARNING: ring wrapped, {capture.dropped} oldest records were dropped")
+
+    runner = args.runner or build_runner()
+    replay = run_replay(runner, capture, args.speed, args.verbose)
+
+    rec_solenoid, rec_state = recorded_timelines(capture)
+    solenoid_ok = diff_timelines(
+        "solenoid", rec_solenoid, replay.solenoid, replay.solenoid_slack, args.tolerance_ms
+    )
+    state_ok = diff_timelines(
+        "firing", rec_state, replay.state, replay.state_slack, args.state_tolerance_ms
+    )
+    if not (solenoid_ok and state_ok):
+        sys.exit(1)
+    print("Replay matches capture.")
+
+
+if __name__ == "__main__":
+    main()
@@ -28,6 +28,10 @@ def main() -> None:
         '"/wifi"',
         "index_handler",
         "wifi_get_handler",
+        '"/wifi/scan"',
+        "wifi_scan_get_handler",
+        '"/config"',
+        "config_get_handler",
     ]
 
     for token in required:
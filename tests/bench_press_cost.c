@@ -0,0 +1,134 @@
+// A/B host benchmark of the firing logic's own cost per fire, without the LED strip refresh that
+// dominates press_cost_us on the device:
+//   A: fire_control.c, reading the hold limits and frames from its cached fire_config_t
+//   B: fire_control.c again, built by bench_press_fixed.c with them as compile-time constants
+// One fire is a press, both frame steps and a release after the minimum hold. The hooks do
+// nothing but keep the levels, so the numbers are the state machine and the hook calls only.
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bench_press_fixed.h"
+#include "fire_control.h"
+
+#define FIRES_PER_ROUND 1000000
+#define ROUNDS 7
+
+typedef struct {
+    int64_t now_us;
+    uint32_t level_sum;
+} bench_t;
+
+static int64_t bench_now_us(void* ctx) {
+    return ((bench_t*)ctx)->now_us;
+}
+
+static void bench_set_levels(void* ctx, const uint8_t* level) {
+    ((bench_t*)ctx)->level_sum += level[0];
+}
+
+static void bench_timer_start(void* ctx, fire_timer_t timer, int64_t delay_us) {
+    (void)ctx;
+    (void)timer;
+    (void)delay_us;
+}
+
+static void bench_timer_stop(void* ctx, fire_timer_t timer) {
+    (void)ctx;
+    (void)timer;
+}
+
+static void bench_on_start(void* ctx) {
+    (void)ctx;
+}
+
+static void bench_on_stop(void* ctx, fire_stop_t reason, uint32_t fired_ms) {
+    (void)ctx;
+    (void)reason;
+    (void)fired_ms;
+}
+
+static int64_t elapsed_ns(const struct timespec* start, const struct timespec* end) {
+    return (int64_t)(end->tv_sec - start->tv_sec) * 1000000000LL + (end->tv_nsec - start->tv_nsec);
+}
+
+static int64_t run_cached(fire_control_t* fire, bench_t* bench) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < FIRES_PER_ROUND; i++) {
+        bench->now_us += 1000000;
+        fire_control_press_down(fire, PRESS_SOURCE_WS);
+        bench->now_us += 50000;
+        fire_control_timer_expired(fire, FIRE_TIMER_FRAME);
+        bench->now_us += 10000;
+        fire_control_timer_expired(fire, FIRE_TIMER_FRAME);
+        bench->now_us += 340000;
+        fire_control_press_up(fire, PRESS_SOURCE_WS);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return elapsed_ns(&start, &end);
+}
+
+static int64_t run_fixed(fire_control_t* fire, bench_t* bench) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < FIRES_PER_ROUND; i++) {
+        bench->now_us += 1000000;
+        fixed_press_down(fire, PRESS_SOURCE_WS);
+        bench->now_us += 50000;
+        fixed_timer_expired(fire, FIRE_TIMER_FRAME);
+        bench->now_us += 10000;
+        fixed_timer_expired(fire, FIRE_TIMER_FRAME);
+        bench->now_us += 340000;
+        fixed_press_up(fire, PRESS_SOURCE_WS);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return elapsed_ns(&start, &end);
+}
+
+int main(void) {
+    bench_t bench = {0};
+    const fire_hooks_t hooks = {
+        .now_us = bench_now_us,
+        .set_levels = bench_set_levels,
+        .timer_start = bench_timer_start,
+        .timer_stop = bench_timer_stop,
+        .on_start = bench_on_start,
+        .on_stop = bench_on_stop,
+        .ctx = &bench,
+    };
+    const fire_config_t config = {
+        .min_hold_ms = BENCH_MIN_HOLD_MS,
+        .max_hold_ms = BENCH_MAX_HOLD_MS,
+        .link_timeout_ms = BENCH_LINK_TIMEOUT_MS,
+        .frames = bench_frames,
+        .frame_count = BENCH_FRAME_COUNT,
+    };
+    fire_control_t cached;
+    fire_control_t fixed;
+    fire_control_init(&cached, &hooks, &config);
+    fixed_init(&fixed, &hooks, &config);
+
+    // Alternate the variants and keep the best round of each, to shed scheduler noise.
+    int64_t best_cached = INT64_MAX;
+    int64_t best_fixed = INT64_MAX;
+    for (int round = 0; round < ROUNDS; round++) {
+        int64_t ns = run_cached(&cached, &bench);
+        best_cached = ns < best_cached ? ns : best_cached;
+        ns = run_fixed(&fixed, &bench);
+        best_fixed = ns < best_fixed ? ns : best_fixed;
+    }
+    if (cached.last_hold_ms != fixed.last_hold_ms || cached.active || fixed.active) {
+        fprintf(stderr, "variants diverged\n");
+        return 1;
+    }
+
+    printf("cached config (A): %.1f ns per fire\n", (double)best_cached / FIRES_PER_ROUND);
+    printf("fixed config  (B): %.1f ns per fire\n", (double)best_fixed / FIRES_PER_ROUND);
+    printf("A - B:             %+.1f ns per fire (level checksum %" PRIu32 ")\n",
+           (double)(best_cached - best_fixed) / FIRES_PER_ROUND, bench.level_sum);
+    return 0;
+}
@@ -0,0 +1,30 @@
+// Variant B for bench_press_cost.c: fire_control.c itself, rebuilt with the hold limits and the
+// frame table as compile-time constants, as they were before the config became runtime-tunable.
+// The logic cannot drift from the firmware, so the only difference measured is where the config
+// is read from. Built in its own translation unit so the hooks are called through pointers
+// exactly as in fire_control.c.
+
+#include "bench_press_fixed.h"
+
+const solenoid_frame_t bench_frames[BENCH_FRAME_COUNT] = {
+    {0, {255, 255}},
+    {50, {208, 208}},
+    {60, {160, 160}},
+};
+
+// The (void) keeps the fire argument used, as the runtime accessors use it.
+#define FIRE_MIN_HOLD_MS(fire) ((void)(fire), (uint32_t)BENCH_MIN_HOLD_MS)
+#define FIRE_MAX_HOLD_MS(fire) ((void)(fire), (uint32_t)BENCH_MAX_HOLD_MS)
+#define FIRE_LINK_TIMEOUT_MS(fire) ((void)(fire), (uint32_t)BENCH_LINK_TIMEOUT_MS)
+#define FIRE_FRAMES(fire) ((void)(fire), bench_frames)
+#define FIRE_FRAME_COUNT(fire) ((void)(fire), (size_t)BENCH_FRAME_COUNT)
+
+#define fire_control_init fixed_init
+#define fire_control_set_config fixed_set_config
+#define fire_control_press_down fixed_press_down
+#define fire_control_press_up fixed_press_up
+#define fire_control_timer_expired fixed_timer_expired
+#define fire_control_poll fixed_poll
+#define fire_control_elapsed_ms fixed_elapsed_ms
+
+#include "fire_control.c"
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "fire_control.h"
+
+// The config both variants run with; variant B has it compiled in.
+#define BENCH_MIN_HOLD_MS 250
+#define BENCH_MAX_HOLD_MS 3000
+#define BENCH_LINK_TIMEOUT_MS 2000
+#define BENCH_FRAME_COUNT 3
+
+extern const solenoid_frame_t bench_frames[BENCH_FRAME_COUNT];
+
+// fire_control.c built a second time with the config above as constants; same contract as the
+// fire_control_* functions of the same name. fire->config is not read.
+void fixed_init(fire_control_t* fire, const fire_hooks_t* hooks, const fire_config_t* config);
+bool fixed_press_down(fire_control_t* fire, press_source_t source);
+void fixed_press_up(fire_control_t* fire, press_source_t source);
+void fixed_timer_expired(fire_control_t* fire, fire_timer_t timer);
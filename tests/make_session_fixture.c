@@ -0,0 +1,436 @@
+// Generates tests/fixtures/session.pfcp, the capture the replay_session test replays.
+//
+// This is a synthetic capture, not a device recording: a scripted controller session is run
+// through firmware/main/fire_control.c with the device side simulated the way main.c wires it
+// up, and every record main.c would capture is written in the GET /capture format. The
+// simulation differs from the replay runner's on purpose, so the replay tolerances are exercised:
+//   - esp_timer callbacks run TIMER_DISPATCH_US after their deadline
+//   - the push task sends a state frame on every PUSH_PERIOD_MS tick while firing, and on the
+//     next tick after a transition
+//   - the link timeout is only checked on the STATUS_PERIOD_MS status tick
+//   - a press during a Wi-Fi scan aborts it, and the scan reports done with no APs
+//
+// Usage, from the repo root:
+//   build/host/make_session_fixture tests/fixtures/session.pfcp           (rewrite it)
+//   build/host/make_session_fixture --check tests/fixtures/session.pfcp   (fail if it differs)
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fire_control.h"
+
+#define CAPTURE_VERSION 3
+#define MAX_RECORDS 1024
+#define RECORD_SIZE 16
+#define HEADER_SIZE 32
+#define FRAME_SIZE 8
+
+#define MIN_HOLD_MS 250
+#define MAX_HOLD_MS 3000
+#define LINK_TIMEOUT_MS 2000
+
+#define TIMER_DISPATCH_US 120
+#define PUSH_PERIOD_MS 20
+#define STATUS_PERIOD_MS 200
+#define SCAN_MS 1820 // 13 channels of 80 ms active scan plus 60 ms home dwell
+#define SCAN_APS 5
+
+// Same values as capture_kind_t and CAPTURE_FLAG_* in main.c.
+enum {
+    CAPTURE_WS_OPEN = 1,
+    CAPTURE_RX_DOWN,
+    CAPTURE_RX_UP,
+    CAPTURE_RX_PING,
+    CAPTURE_RX_OTHER,
+    CAPTURE_TX_STATE,
+    CAPTURE_SOLENOID,
+    CAPTURE_TRIGGER_DOWN,
+    CAPTURE_TRIGGER_UP,
+    CAPTURE_SCAN_START,
+    CAPTURE_SCAN_DONE,
+};
+
+#define CAPTURE_FLAG_READY (1U << 0)
+#define CAPTURE_FLAG_FIRING (1U << 1)
+#define CAPTURE_FLAG_CONNECTED (1U << 3)
+
+typedef enum {
+    IN_OPEN,
+    IN_DOWN,
+    IN_UP,
+    IN_PING,
+    IN_TDOWN,
+    IN_TUP,
+    IN_SCAN, // the status task starting a scheduled scan
+} input_kind_t;
+
+typedef struct {
+    uint32_t at_ms;
+    input_kind_t kind;
+} input_t;
+
+typedef struct {
+    uint32_t t_us;
+    uint8_t kind;
+    uint8_t flags;
+    uint8_t level[SOLENOID_CHANNELS];
+    uint32_t a;
+    uint32_t b;
+} record_t;
+
+typedef struct {
+    int64_t now_us;
+    bool armed[FIRE_TIMER_COUNT];
+    int64_t due_us[FIRE_TIMER_COUNT];
+    int64_t last_rx_us;
+    bool connected;
+    bool push_pending;
+    bool scanning;
+    int64_t scan_start_us;
+    record_t records[MAX_RECORDS];
+    size_t count;
+} sim_t;
+
+// What build_solenoid_frames() makes of the default profiles in main.c.
+static const solenoid_frame_t frames[] = {
+    {0, {255, 255}},
+    {50, {224, 224}},
+    {60, {192, 192}},
+    {70, {160, 160}},
+};
+
+// The session, in order. Comments give what the firmware is expected to do.
+static const input_t session[] = {
+    {0, IN_OPEN},
+    {5, IN_PING},
+    // A plain press and release.
+    {305, IN_DOWN},
+    {905, IN_UP},
+    // Released before min hold: the stop is deferred to 250 ms after the press.
+    {1305, IN_DOWN},
+    {1385, IN_UP},
+    // Held with the link alive until the max-hold cutoff at 4985 ms; the DOWN after it is
+    // ignored until the UP clears the cutoff.
+    {1985, IN_DOWN},
+    {2885, IN_PING},
+    {3785, IN_PING},
+    {4685, IN_PING},
+    {5185, IN_DOWN},
+    {5285, IN_UP},
+    {5485, IN_DOWN},
+    {5985, IN_UP},
+    // A trigger burn: the stray WS UP does not end it, the trigger release does.
+    {6285, IN_PING},
+    {6485, IN_TDOWN},
+    {6585, IN_UP},
+    {6785, IN_PING},
+    {7185, IN_TUP},
+    {7485, IN_PING},
+    // The controller goes silent mid-press: the link timeout ends it on a status tick.
+    {7785, IN_DOWN},
+    {10985, IN_PING},
+    {11085, IN_UP},
+    // A scan that runs to completion, then one aborted by a press.
+    {12000, IN_SCAN},
+    {12905, IN_PING},
+    {13805, IN_PING},
+    {14705, IN_PING},
+    {15000, IN_SCAN},
+    {15405, IN_PING},
+    {15500, IN_DOWN},
+    {16000, IN_UP},
+    {16305, IN_PING},
+    // Cut off at max hold at 20005 ms, then the controller drops without sending UP. The
+    // trigger still fires; the controller's own DOWN is ignored until its UP.
+    {17005, IN_DOWN},
+    {17905, IN_PING},
+    {18805, IN_PING},
+    {19705, IN_PING},
+    {23000, IN_TDOWN},
+    {23500, IN_TUP},
+    {24000, IN_OPEN},
+    {24005, IN_DOWN},
+    {24105, IN_UP},
+    {24305, IN_DOWN},
+    {24805, IN_UP},
+};
+
+#define END_MS 25500
+
+static void record(sim_t* sim, uint8_t kind, uint8_t flags, const uint8_t* level, uint32_t a,
+                   uint32_t b) {
+    if (sim->count == MAX_RECORDS) {
+        fprintf(stderr, "session does not fit in the capture ring\n");
+        exit(1);
+    }
+    record_t* rec = &sim->records[sim->count++];
+    memset(rec, 0, sizeof(*rec));
+    rec->t_us = (uint32_t)sim->now_us;
+    rec->kind = kind;
+    rec->flags = flags;
+    if (level) {
+        memcpy(rec->level, level, sizeof(rec->level));
+    }
+    rec->a = a;
+    rec->b = b;
+}
+
+static void scan_done(sim_t* sim, uint32_t aps) {
+    sim->scanning = false;
+    record(sim, CAPTURE_SCAN_DONE, 0, NULL, aps,
+           (uint32_t)((sim->now_us - sim->scan_start_us) / 1000));
+}
+
+static int64_t sim_now_us(void* ctx) {
+    return ((sim_t*)ctx)->now_us;
+}
+
+static void sim_set_levels(void* ctx, const uint8_t* level) {
+    record(ctx, CAPTURE_SOLENOID, 0, level, 0, 0);
+}
+
+static void sim_timer_start(void* ctx, fire_timer_t timer, int64_t delay_us) {
+    sim_t* sim = ctx;
+    sim->armed[timer] = true;
+    sim->due_us[timer] = sim->now_us + delay_us + TIMER_DISPATCH_US;
+}
+
+static void sim_timer_stop(void* ctx, fire_timer_t timer) {
+    ((sim_t*)ctx)->armed[timer] = false;
+}
+
+static void sim_on_start(void* ctx) {
+    sim_t* sim = ctx;
+    sim->push_pending = true;
+    if (sim->scanning) {
+        scan_done(sim, 0);
+    }
+}
+
+static void sim_on_stop(void* ctx, fire_stop_t reason, uint32_t fired_ms) {
+    sim_t* sim = ctx;
+    (void)fired_ms;
+    sim->push_pending = true;
+    if (reason == FIRE_STOP_LINK) {
+        sim->connected = false;
+    }
+}
+
+static void handle_input(fire_control_t* fire, sim_t* sim, input_kind_t kind) {
+    switch (kind) {
+    case IN_OPEN:
+        record(sim, CAPTURE_WS_OPEN, 0, NULL, 0, 0);
+        break;
+    case IN_DOWN:
+        record(sim, CAPTURE_RX_DOWN, 0, NULL, 4, 0);
+        break;
+    case IN_UP:
+        record(sim, CAPTURE_RX_UP, 0, NULL, 2, 0);
+        break;
+    case IN_PING:
+        record(sim, CAPTURE_RX_PING, 0, NULL, 4, 0);
+        break;
+    case IN_TDOWN:
+        record(sim, CAPTURE_TRIGGER_DOWN, 0, NULL, 0, 0);
+        fire_control_press_down(fire, PRESS_SOURCE_TRIGGER);
+        return;
+    case IN_TUP:
+        record(sim, CAPTURE_TRIGGER_UP, 0, NULL, 0, 0);
+        fire_control_press_up(fire, PRESS_SOURCE_TRIGGER);
+        return;
+    case IN_SCAN:
+        if (!sim->scanning && !fire->active) {
+            sim->scanning = true;
+            sim->scan_start_us = sim->now_us;
+            record(sim, CAPTURE_SCAN_START, 0, NULL, 0, 0);
+        }
+        return;
+    }
+
+    // Every inbound WebSocket frame counts as link activity, as in handle_ws_message.
+    sim->last_rx_us = sim->now_us;
+    sim->connected = true;
+    if (kind == IN_DOWN) {
+        fire_control_press_down(fire, PRESS_SOURCE_WS);
+    } else if (kind == IN_UP) {
+        fire_control_press_up(fire, PRESS_SOURCE_WS);
+    } else {
+        sim->push_pending = true;
+    }
+}
+
+static void push_tick(fire_control_t* fire, sim_t* sim) {
+    if (!sim->push_pending && !fire->active) {
+        return;
+    }
+    sim->push_pending = false;
+    uint8_t flags = CAPTURE_FLAG_READY | (fire->active ? CAPTURE_FLAG_FIRING : 0) |
+                    (sim->connected ? CAPTURE_FLAG_CONNECTED : 0);
+    record(sim, CAPTURE_TX_STATE, flags, NULL, fire_control_elapsed_ms(fire), fire->last_hold_ms);
+}
+
+static void status_tick(fire_control_t* fire, sim_t* sim) {
+    fire_control_poll(fire, sim->last_rx_us);
+    if (sim->connected &&
+        sim->now_us - sim->last_rx_us > (int64_t)LINK_TIMEOUT_MS * 1000LL) {
+        sim->connected = false;
+        sim->push_pending = true;
+    }
+}
+
+static void run_session(sim_t* sim) {
+    const fire_hooks_t hooks = {
+        .now_us = sim_now_us,
+        .set_levels = sim_set_levels,
+        .timer_start = sim_timer_start,
+        .timer_stop = sim_timer_stop,
+        .on_start = sim_on_start,
+        .on_stop = sim_on_stop,
+        .ctx = sim,
+    };
+    const fire_config_t config = {
+        .min_hold_ms = MIN_HOLD_MS,
+        .max_hold_ms = MAX_HOLD_MS,
+        .link_timeout_ms = LINK_TIMEOUT_MS,
+        .frames = frames,
+        .frame_count = sizeof(frames) / sizeof(frames[0]),
+    };
+    fire_control_t fire;
+    fire_control_init(&fire, &hooks, &config);
+
+    // The periodic tasks are offset from the round-millisecond inputs so nothing ties.
+    int64_t next_push_us = 10000;
+    int64_t next_status_us = 100000;
+    size_t next_input = 0;
+    const size_t input_count = sizeof(session) / sizeof(session[0]);
+    while (true) {
+        int64_t due_us = (int64_t)END_MS * 1000LL;
+        int next_timer = -1;
+        for (int timer = 0; timer < FIRE_TIMER_COUNT; timer++) {
+            if (sim->armed[timer] && sim->due_us[timer] < due_us) {
+                next_timer = timer;
+                due_us = sim->due_us[timer];
+            }
+        }
+        int64_t input_us = next_input < input_count
+                               ? (int64_t)session[next_input].at_ms * 1000LL
+                               : INT64_MAX;
+        int64_t scan_us = sim->scanning ? sim->scan_start_us + (int64_t)SCAN_MS * 1000LL
+                                        : INT64_MAX;
+        int64_t first_us = due_us;
+        first_us = input_us < first_us ? input_us : first_us;
+        first_us = scan_us < first_us ? scan_us : first_us;
+        first_us = next_push_us < first_us ? next_push_us : first_us;
+        first_us = next_status_us < first_us ? next_status_us : first_us;
+        if (first_us >= (int64_t)END_MS * 1000LL) {
+            break;
+        }
+        sim->now_us = first_us;
+
+        if (next_timer >= 0 && due_us == first_us) {
+            sim->armed[next_timer] = false;
+            fire_control_timer_expired(&fire, (fire_timer_t)next_timer);
+        } else if (input_us == first_us) {
+            handle_input(&fire, sim, session[next_input++].kind);
+        } else if (scan_us == first_us) {
+            scan_done(sim, SCAN_APS);
+        } else if (next_status_us == first_us) {
+            status_tick(&fire, sim);
+            next_status_us += STATUS_PERIOD_MS * 1000LL;
+        } else {
+            push_tick(&fire, sim);
+            next_push_us += PUSH_PERIOD_MS * 1000LL;
+        }
+    }
+}
+
+static void put_u16(uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void put_u32(uint8_t* out, uint32_t value) {
+    put_u16(out, (uint16_t)value);
+    put_u16(out + 2, (uint16_t)(value >> 16));
+}
+
+// Lays the capture out as capture_get_handler sends it, little-endian as on the ESP32-C3.
+static size_t encode(const sim_t* sim, uint8_t* out) {
+    const size_t frame_count = sizeof(frames) / sizeof(frames[0]);
+    memcpy(out, "PFCP", 4);
+    put_u16(out + 4, CAPTURE_VERSION);
+    put_u16(out + 6, RECORD_SIZE);
+    put_u32(out + 8, (uint32_t)sim->count);
+    put_u32(out + 12, 0);
+    put_u32(out + 16, MIN_HOLD_MS);
+    put_u32(out + 20, MAX_HOLD_MS);
+    put_u32(out + 24, LINK_TIMEOUT_MS);
+    put_u32(out + 28, (uint32_t)frame_count);
+    size_t len = HEADER_SIZE;
+
+    for (size_t i = 0; i < frame_count; i++) {
+        uint8_t* frame = out + len;
+        memset(frame, 0, FRAME_SIZE);
+        put_u32(frame, frames[i].at_ms);
+        memcpy(frame + 4, frames[i].level, SOLENOID_CHANNELS);
+        len += FRAME_SIZE;
+    }
+    for (size_t i = 0; i < sim->count; i++) {
+        const record_t* rec = &sim->records[i];
+        uint8_t* raw = out + len;
+        put_u32(raw, rec->t_us);
+        raw[4] = rec->kind;
+        raw[5] = rec->flags;
+        memcpy(raw + 6, rec->level, SOLENOID_CHANNELS);
+        put_u32(raw + 8, rec->a);
+        put_u32(raw + 12, rec->b);
+        len += RECORD_SIZE;
+    }
+    return len;
+}
+
+static int check(const char* path, const uint8_t* data, size_t len) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return 1;
+    }
+    static uint8_t stored[HEADER_SIZE + 64 * FRAME_SIZE + MAX_RECORDS * RECORD_SIZE + 1];
+    size_t stored_len = fread(stored, 1, sizeof(stored), file);
+    fclose(file);
+    if (stored_len != len || memcmp(stored, data, len) != 0) {
+        fprintf(stderr, "%s is out of date; regenerate it with make_session_fixture\n", path);
+        return 1;
+    }
+    printf("%s is up to date\n", path);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    bool check_only = argc == 3 && strcmp(argv[1], "--check") == 0;
+    if (argc != 2 && !check_only) {
+        fprintf(stderr, "usage: %s [--check] <session.pfcp>\n", argv[0]);
+        return 2;
+    }
+    const char* path = argv[argc - 1];
+
+    static sim_t sim;
+    run_session(&sim);
+    static uint8_t data[HEADER_SIZE + 64 * FRAME_SIZE + MAX_RECORDS * RECORD_SIZE];
+    size_t len = encode(&sim, data);
+    if (check_only) {
+        return check(path, data, len);
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file || fwrite(data, 1, len, file) != len) {
+        perror(path);
+        return 1;
+    }
+    fclose(file);
+    printf("wrote %s: %zu records\n", path, sim.count);
+    return 0;
+}
@@ -0,0 +1,167 @@
+// Host replay runner for firmware/main/fire_control.c, driven by scripts/replay_capture.py.
+//
+// Reads the capture config and timestamped inputs on stdin and prints the solenoid and firing
+// timelines the firmware's own state machine produces. Time is simulated: one-shot timers fire
+// exactly at their deadline, and the link timeout is checked at the first microsecond past it
+// (the device only checks it on the 200 ms status tick; the script allows for that).
+//
+// Input, one per line:
+//   config <min_hold_ms> <max_hold_ms> <link_timeout_ms>
+//   frame <at_ms> <level0> <level1>
+//   <t_us> ws|down|up|tdown|tup
+//   end <t_us>
+//
+// Output, one per line:
+//   sol <t_us> <level0> <level1>
+//   fire <t_us> 1
+//   fire <t_us> 0 release|max_hold|link
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fire_control.h"
+
+#define MAX_FRAMES 64
+
+typedef struct {
+    int64_t now_us;
+    bool armed[FIRE_TIMER_COUNT];
+    int64_t due_us[FIRE_TIMER_COUNT];
+} sim_t;
+
+static const char* const stop_names[] = {"release", "max_hold", "link"};
+
+static int64_t sim_now_us(void* ctx) {
+    return ((sim_t*)ctx)->now_us;
+}
+
+static void sim_set_levels(void* ctx, const uint8_t* level) {
+    sim_t* sim = ctx;
+    printf("sol %" PRId64 " %u %u\n", sim->now_us, level[0], level[1]);
+}
+
+static void sim_timer_start(void* ctx, fire_timer_t timer, int64_t delay_us) {
+    sim_t* sim = ctx;
+    sim->armed[timer] = true;
+    sim->due_us[timer] = sim->now_us + delay_us;
+}
+
+static void sim_timer_stop(void* ctx, fire_timer_t timer) {
+    ((sim_t*)ctx)->armed[timer] = false;
+}
+
+static void sim_on_start(void* ctx) {
+    printf("fire %" PRId64 " 1\n", ((sim_t*)ctx)->now_us);
+}
+
+static void sim_on_stop(void* ctx, fire_stop_t reason, uint32_t fired_ms) {
+    (void)fired_ms;
+    printf("fire %" PRId64 " 0 %s\n", ((sim_t*)ctx)->now_us, stop_names[reason]);
+}
+
+// Runs every timer and link check due up to and including until_us, in deadline order.
+static void advance(fire_control_t* fire, sim_t* sim, int64_t last_rx_us, int64_t until_us) {
+    while (true) {
+        int next = -1;
+        int64_t due_us = until_us + 1;
+        for (int timer = 0; timer < FIRE_TIMER_COUNT; timer++) {
+            if (sim->armed[timer] && sim->due_us[timer] < due_us) {
+                next = timer;
+                due_us = sim->due_us[timer];
+            }
+        }
+        if (fire->active && fire->source == PRESS_SOURCE_WS && last_rx_us != 0) {
+            int64_t link_us = last_rx_us + (int64_t)fire->config.link_timeout_ms * 1000LL + 1;
+            if (link_us < due_us) {
+                next = FIRE_TIMER_COUNT;
+                due_us = link_us;
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+        if (due_us > sim->now_us) {
+            sim->now_us = due_us;
+        }
+        if (next == FIRE_TIMER_COUNT) {
+            fire_control_poll(fire, last_rx_us);
+        } else {
+            sim->armed[next] = false;
+            fire_control_timer_expired(fire, (fire_timer_t)next);
+        }
+    }
+    if (until_us > sim->now_us) {
+        sim->now_us = until_us;
+    }
+}
+
+int main(void) {
+    static solenoid_frame_t frames[MAX_FRAMES];
+    fire_config_t config = {.frames = frames};
+    sim_t sim = {0};
+    const fire_hooks_t hooks = {
+        .now_us = sim_now_us,
+        .set_levels = sim_set_levels,
+        .timer_start = sim_timer_start,
+        .timer_stop = sim_timer_stop,
+        .on_start = sim_on_start,
+        .on_stop = sim_on_stop,
+        .ctx = &sim,
+    };
+    fire_control_t fire;
+    bool started = false;
+    int64_t last_rx_us = 0;
+
+    char line[128];
+    while (fgets(line, sizeof(line), stdin)) {
+        unsigned min_hold, max_hold, link, at_ms, l0, l1;
+        long long t_us;
+        char event[16];
+        if (sscanf(line, "config %u %u %u", &min_hold, &max_hold, &link) == 3) {
+            config.min_hold_ms = min_hold;
+            config.max_hold_ms = max_hold;
+            config.link_timeout_ms = link;
+            continue;
+        }
+        if (sscanf(line, "frame %u %u %u", &at_ms, &l0, &l1) == 3) {
+            if (config.frame_count == MAX_FRAMES) {
+                fprintf(stderr, "too many frames\n");
+                return 1;
+            }
+            frames[config.frame_count++] =
+                (solenoid_frame_t){.at_ms = at_ms, .level = {(uint8_t)l0, (uint8_t)l1}};
+            continue;
+        }
+        if (!started) {
+            fire_control_init(&fire, &hooks, &config);
+            started = true;
+        }
+        if (sscanf(line, "end %lld", &t_us) == 1) {
+            advance(&fire, &sim, last_rx_us, t_us);
+            break;
+        }
+        if (sscanf(line, "%lld %15s", &t_us, event) != 2) {
+            fprintf(stderr, "bad input: %s", line);
+            return 1;
+        }
+        advance(&fire, &sim, last_rx_us, t_us);
+        if (strcmp(event, "tdown") == 0) {
+            fire_control_press_down(&fire, PRESS_SOURCE_TRIGGER);
+        } else if (strcmp(event, "tup") == 0) {
+            fire_control_press_up(&fire, PRESS_SOURCE_TRIGGER);
+        } else {
+            // Every inbound WebSocket frame counts as link activity, as in handle_ws_message.
+            last_rx_us = t_us;
+            if (strcmp(event, "down") == 0) {
+                fire_control_press_down(&fire, PRESS_SOURCE_WS);
+            } else if (strcmp(event, "up") == 0) {
+                fire_control_press_up(&fire, PRESS_SOURCE_WS);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Drives firmware/main/trigger_debounce.c with synthetic edge traces the way trigger_task does:
+// one update per edge, plus one at every pending deadline with the level still on the pin.
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "trigger_debounce.h"
+
+#define DEBOUNCE_US 10000
+#define MAX_EVENTS 8
+
+typedef struct {
+    int64_t t_us;
+    bool active;
+} edge_t;
+
+typedef struct {
+    int64_t t_us;
+    trigger_event_t event;
+} event_t;
+
+typedef struct {
+    const char* name;
+    const edge_t* edges;
+    size_t edge_count;
+    int64_t end_us;
+    const event_t* expected;
+    size_t expected_count;
+} trace_t;
+
+static size_t record(event_t* events, size_t count, int64_t t_us, trigger_event_t event) {
+    if (event != TRIGGER_EVENT_NONE && count < MAX_EVENTS) {
+        events[count++] = (event_t){.t_us = t_us, .event = event};
+    }
+    return count;
+}
+
+// Runs every deadline before until_us against the current level.
+static size_t run_deadlines(trigger_debounce_t* debounce, bool level, int64_t until_us,
+                            event_t* events, size_t count) {
+    int64_t due_us;
+    while (trigger_debounce_deadline(debounce, &due_us) && due_us < until_us) {
+        count = record(events, count, due_us, trigger_debounce_update(debounce, level, due_us));
+    }
+    return count;
+}
+
+static bool run_trace(const trace_t* trace) {
+    trigger_debounce_t debounce;
+    trigger_debounce_init(&debounce, DEBOUNCE_US);
+    event_t events[MAX_EVENTS];
+    size_t count = 0;
+    bool level = false;
+
+    for (size_t i = 0; i < trace->edge_count; i++) {
+        const edge_t* edge = &trace->edges[i];
+        count = run_deadlines(&debounce, level, edge->t_us, events, count);
+        level = edge->active;
+        count = record(events, count, edge->t_us,
+                       trigger_debounce_update(&debounce, level, edge->t_us));
+    }
+    count = run_deadlines(&debounce, level, trace->end_us, events, count);
+
+    bool ok = count == trace->expected_count;
+    for (size_t i = 0; ok && i < count; i++) {
+        ok = events[i].t_us == trace->expected[i].t_us &&
+             events[i].event == trace->expected[i].event;
+    }
+    if (!ok) {
+        printf("FAIL %s: got", trace->name);
+        for (size_t i = 0; i < count; i++) {
+            printf(" %s@%" PRId64, events[i].event == TRIGGER_EVENT_PRESS ? "press" : "release",
+                   events[i].t_us);
+        }
+        printf("\n");
+    }
+    return ok;
+}
+
+// Contact bounce on the press edge: the first edge fires and the bounce never reads as a release.
+static const edge_t bouncy_press[] = {
+    {0, true}, {300, false}, {600, true}, {1000, false}, {1400, true}, {200000, false},
+};
+static const event_t bouncy_press_expected[] = {
+    {0, TRIGGER_EVENT_PRESS},
+    {210000, TRIGGER_EVENT_RELEASE},
+};
+
+// Contact bounce on the release edge: each bounce restarts the release, which lands one debounce
+// period after the last edge and does not re-press.
+static const edge_t bouncy_release[] = {
+    {0, true}, {100000, false}, {100200, true}, {100500, false}, {101000, true}, {101300, false},
+};
+static const event_t bouncy_release_expected[] = {
+    {0, TRIGGER_EVENT_PRESS},
+    {111300, TRIGGER_EVENT_RELEASE},
+};
+
+// After a release the input is locked out for one debounce period: a bounce inside it is
+// dropped, and a press held into it is taken when the lockout ends.
+static const edge_t press_in_lockout[] = {
+    {0, true}, {50000, false}, {62000, true}, {63000, false}, {65000, true}, {150000, false},
+};
+static const event_t press_in_lockout_expected[] = {
+    {0, TRIGGER_EVENT_PRESS},
+    {60000, TRIGGER_EVENT_RELEASE},
+    {70000, TRIGGER_EVENT_PRESS},
+    {160000, TRIGGER_EVENT_RELEASE},
+};
+
+#define TRACE(edges, end_us)                                                                     \
+    {#edges, edges, sizeof(edges) / sizeof(edges[0]), end_us, edges##_expected,                  \
+     sizeof(edges##_expected) / sizeof(edges##_expected[0])}
+
+int main(void) {
+    static const trace_t traces[] = {
+        TRACE(bouncy_press, 300000),
+        TRACE(bouncy_release, 300000),
+        TRACE(press_in_lockout, 300000),
+    };
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(traces) / sizeof(traces[0]); i++) {
+        if (!run_trace(&traces[i])) {
+            failures++;
+        }
+    }
+    if (failures == 0) {
+        printf("trigger debounce: %zu traces passed\n", sizeof(traces) / sizeof(traces[0]));
+    }
+    return failures == 0 ? 0 : 1;
+}